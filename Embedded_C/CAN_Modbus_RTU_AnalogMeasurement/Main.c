@@ -17,6 +17,14 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 #include "../CAN_bus.h"  // Include extended CAN ID protocol definitions
+#define CAN_BUSLOAD_BUCKET_SHIFT 32  // 16 buckets of 4.3 s, bus load over about the last minute
+#include "../CAN_busload.h"  // Bit accurate bus load per priority class
+#include "series_stats.h"    // Windowed statistics per sensor series
+#include "series_compress.h" // Deadband / swinging door compression per series
+#include "series_store.h"    // Local history, Gorilla compressed
+#include "line_protocol.h"   // InfluxDB line protocol builder
+#include "http_sink.h"       // Compressed concurrent batch writes
+#include "mongo_bucket.h"    // Time bucketed MongoDB sensor documents
 #include <libmongoc-1.0/mongoc.h>
 #include <libbson-1.0/bson.h>
 
@@ -35,10 +43,9 @@ void cleanup_resources();
 void handle_signal(int sig);
 bool read_temperature_humidity_rtu(int serial_fd, int gpio_pin, float *temperature, float *humidity);
 bool read_resistor_data_rtu(int serial_fd, int gpio_pin);
-bool write_to_influxdb(float temperature, float humidity, const char* source);
-bool write_resistor_data_to_influxdb(float v1, float v2, float v3, float current, float p1, float p2, float p3, const char* source);
-bool write_microphone_data_to_influxdb(uint16_t mic_level, uint8_t device_id, const char *source);
-bool write_vibration_data_to_influxdb(uint8_t vib_state, const char *sensor_id, uint8_t device_id, const char *source);
+bool write_resistor_data_to_influxdb(float v1, float v2, float v3, float current, float p1, float p2, float p3, const char* source, int64_t timestamp_ms);
+bool write_microphone_data_to_influxdb(float mic_level, uint8_t device_id, const char *source, int64_t timestamp_ms);
+bool write_vibration_data_to_influxdb(uint8_t vib_state, const char *sensor_id, uint8_t device_id, const char *source, int64_t timestamp_ms);
 void process_all_can_messages(int can_socket);
 void print_statistics();
 void update_device_activity(uint8_t device_id, const char *device_type);
@@ -46,6 +53,7 @@ void check_device_status();
 void update_device_status_in_mongodb(uint8_t device_id, bool is_active);
 void save_device_info_to_mongodb(uint8_t device_id, const char *device_type);
 void print_device_statistics();
+static int64_t realtime_ms(void);
 
 // Configuration
 #define SERIAL_PORT "/dev/ttyAMA0"  // UART port on RPi
@@ -53,6 +61,32 @@ void print_device_statistics();
 #define SLAVE_ID 3                  // ESP32 Modbus slave ID
 #define MODBUS_SLAVE_ID SLAVE_ID    // Alias for consistency
 #define CAN_INTERFACE "can0"        // CAN interface name
+#define CAN_BITRATE 500000          // Bit rate of CAN_INTERFACE, for the bus load
+
+// Environment data goes to InfluxDB as windowed statistics instead of one
+// write per reading: every STATS_PANE_SEC the last STATS_PANES panes
+#define STATS_PANE_SEC 10
+#define STATS_PANES 6                       // 60 s windows, 1 for tumbling windows
+#define STATS_RAW_SAMPLES 65536             // recent raw readings kept in memory
+#define FIELD_TEMPERATURE 0
+#define FIELD_HUMIDITY 1
+
+// Microphone, vibration and resistor data is written by exception: only the
+// readings needed to rebuild each series within its band (see series_compress.h)
+// and at least one per COMPRESS_MAX_SILENCE_MS
+#define COMPRESS_MAX_SILENCE_MS 60000
+#define MIC_LEVEL_BAND 8.0                  // raw level, swinging door
+#define RESISTOR_BAND_PERCENT 1.0           // of the last written value
+#define RESISTOR_BAND_MIN 0.001             // one register step (V, A, W)
+
+// Every raw reading is also kept locally, the oldest blocks are reused once
+// the file is full
+#define STORE_PATH "series_store.db"
+#define STORE_BLOCKS 16384                  // 64 MiB, about 10 million readings
+
+// MongoDB sensor documents, one per series and minute
+#define MONGO_BUCKET_MS 60000
+#define MONGO_FLUSH_SEC 10                  // pending readings written this often
 
 // CAN message IDs using extended CAN ID protocol
 // Legacy plain CAN IDs for backward compatibility
@@ -103,6 +137,11 @@ void print_device_statistics();
 #define INFLUXDB_URL "http://localhost:8086/ping"
 #define INFLUXDB_WRITE_URL "http://localhost:8086/api/v2/write?org=1ad9946d95ed1f17&bucket=_monitoring&precision=ns"
 #define INFLUXDB_TOKEN "n42FdVEFModulJNOGZDYP1wqbbr0VQeeVlSC85hAWh4_olF_5K217koKdfxiAnNe9gzLGxuX6sCQamxVAiNuEA=="
+#define INFLUX_INFLIGHT 4           // concurrent write requests
+#define INFLUX_BATCH_BYTES 65536    // a batch is sent once this full...
+#define INFLUX_FLUSH_MS 1000        // ...or this old
+#define INFLUX_MAX_ATTEMPTS 5
+#define INFLUX_RETRY_MS 500         // doubled per attempt
 
 // Global variables
 LogLevel log_level = LOG_INFO;
@@ -113,8 +152,37 @@ LogLevel log_level = LOG_INFO;
 static unsigned long modbus_queries = 0;
 static unsigned long modbus_replies = 0;
 static unsigned long can_messages = 0;
-static unsigned long influx_writes = 0;
+static unsigned long influx_lines_written = 0;
 static unsigned long error_count = 0;
+static can_busload_meter_t can_busload;
+static series_stats_t env_stats;
+static unsigned long stats_points = 0;
+static series_compress_t compression;
+static series_store_t store;
+
+// Lines of the next InfluxDB batch, reused from batch to batch
+static lp_buffer_t influx_batch;
+static int64_t influx_batch_started = 0;
+static http_sink_t influx_sink;
+
+// Measurement and tags of every series, escaped once
+#define PREFIX_CACHE_SIZE 64
+typedef struct {
+    bool used;
+    uint32_t id;
+    lp_prefix_t prefix;
+} series_prefix_t;
+static series_prefix_t prefix_cache[PREFIX_CACHE_SIZE];
+
+static const series_compress_config_t microphone_compression = {
+    SERIES_COMPRESS_SWINGING_DOOR, MIC_LEVEL_BAND, 0.0, COMPRESS_MAX_SILENCE_MS
+};
+static const series_compress_config_t vibration_compression = {
+    SERIES_COMPRESS_DEADBAND, 0.5, 0.0, COMPRESS_MAX_SILENCE_MS    // every change of state
+};
+static const series_compress_config_t resistor_compression = {
+    SERIES_COMPRESS_DEADBAND, RESISTOR_BAND_MIN, RESISTOR_BAND_PERCENT, COMPRESS_MAX_SILENCE_MS
+};
 
 // Control flag for main loop
 static volatile bool running = true;
@@ -128,6 +196,8 @@ static mongoc_client_t *mongo_client = NULL;
 static mongoc_database_t *database = NULL;
 static mongoc_collection_t *devices_collection = NULL;
 static mongoc_collection_t *sensors_collection = NULL;
+static mongo_bucket_writer_t mongo_buckets;
+static const char *const environment_fields[] = { "temperature", "humidity" };
 
 // Device status tracking
 #define DEVICE_TIMEOUT_SECONDS 60  // Time after which device is considered inactive
@@ -373,44 +443,48 @@ void save_device_info_to_mongodb(uint8_t device_id, const char *device_type) {
     bson_destroy(query);
 }
 
-// Save sensor reading to MongoDB
+// Save sensor reading to MongoDB, into the bucket of its series and minute
 bool save_sensor_data_to_mongodb(const char* id_type, uint8_t device_id, const char* sensor_type, float temp, float humid) {
-    bson_t *doc;
-    bson_error_t error;
-    time_t now = time(NULL);
-    char timestamp[30];
-    char id_str[10];
-    
-    sprintf(id_str, "%02X", device_id);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    const double values[2] = { temp, humid };
     
-    doc = bson_new();
-    BSON_APPEND_UTF8(doc, "device_id", id_str);
-    BSON_APPEND_UTF8(doc, "id_type", id_type);
-    BSON_APPEND_UTF8(doc, "sensor_type", sensor_type);
-    BSON_APPEND_UTF8(doc, "timestamp", timestamp);
-    BSON_APPEND_DOUBLE(doc, "temperature", temp);
-    BSON_APPEND_DOUBLE(doc, "humidity", humid);
-    
-    if (!mongoc_collection_insert_one(sensors_collection, doc, NULL, NULL, &error)) {
-        log_message(LOG_ERROR, "MongoDB sensor data insert error: %s", error.message);
-        bson_destroy(doc);
+    if (!mongo_bucket_add(&mongo_buckets, id_type, device_id, sensor_type, environment_fields, 2, realtime_ms(), values)) {
+        log_message(LOG_ERROR, "MongoDB sensor bucket error: %s", mongo_buckets.error.message);
         return false;
     }
     
-    log_message(LOG_DEBUG, "Saved sensor data to MongoDB: Device=0x%s, Temp=%.1f, Humid=%.1f",
-               id_str, temp, humid);
-    
-    bson_destroy(doc);
+    log_message(LOG_DEBUG, "Queued sensor data for MongoDB: Device=0x%02X, Temp=%.1f, Humid=%.1f",
+               device_id, temp, humid);
     return true;
 }
 
+// Write the readings queued since the last flush
+static void flush_sensor_buckets(void) {
+    if (!mongo_bucket_flush(&mongo_buckets)) {
+        error_count++;
+        log_message(LOG_ERROR, "MongoDB sensor bucket write error: %s", mongo_buckets.error.message);
+    }
+}
+
 // Signal handler for graceful termination
 void handle_signal(int sig) {
     log_message(LOG_INFO, "Signal %d received. Exiting...", sig);
     running = 0;
 }
 
+// Monotonic time in nanoseconds for the bus load window
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Wall clock time for the statistics windows and InfluxDB timestamps
+static int64_t realtime_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 // Function to delay milliseconds
 void delay_ms(int milliseconds) {
     struct timespec ts;
@@ -491,6 +565,8 @@ bool init_curl_resources() {
 
 // Clean up CURL resources
 void cleanup_curl_resources() {
+    http_sink_cleanup(&influx_sink);
+    
     if (headers) {
         curl_slist_free_all(headers);
         headers = NULL;
@@ -543,197 +619,291 @@ bool test_influxdb_connection() {
     return connection_successful;
 }
 
-// Write temperature and humidity data to InfluxDB
-bool write_to_influxdb(float temperature, float humidity, const char *source) {
-    CURLcode res;
-    bool write_successful = false;
-    static char data[256];  // Static to avoid stack allocations
+// Acknowledged or lost InfluxDB batches
+static void influx_batch_result(void *context, uint32_t lines, long status, bool acked) {
+    (void)context;
+    if (acked) {
+        influx_lines_written += lines;
+        log_message(LOG_DEBUG, "InfluxDB acknowledged %u points", lines);
+    } else {
+        error_count++;
+        log_message(LOG_ERROR, "Lost %u points for InfluxDB: HTTP code %ld", lines, status);
+    }
+}
+
+// Start the InfluxDB writer, gzip compressed batches over keep-alive connections
+static bool init_influx_sink(void) {
+    http_sink_config_t config = {
+        .url = INFLUXDB_WRITE_URL,
+        .headers = headers,
+        .inflight = INFLUX_INFLIGHT,
+        .encoding = HTTP_SINK_GZIP,
+        .max_attempts = INFLUX_MAX_ATTEMPTS,
+        .retry_ms = INFLUX_RETRY_MS,
+        .timeout_ms = 3000,
+        .on_result = influx_batch_result,
+    };
+    return http_sink_init(&influx_sink, &config);
+}
+
+// Hand the batch to the sink once it is full or old enough, force for shutdown
+static void flush_influx_batch(bool force) {
+    int64_t now = realtime_ms();
     
-    log_message(LOG_DEBUG, "Writing to InfluxDB - Source: %s, Temperature: %.2f, Humidity: %.2f", 
-                source, temperature, humidity);
+    if (influx_batch.lines > 0 &&
+        (force || influx_batch.len >= INFLUX_BATCH_BYTES || now - influx_batch_started >= INFLUX_FLUSH_MS)) {
+        if (!http_sink_send(&influx_sink, influx_batch.data, influx_batch.len, (uint32_t)influx_batch.lines)) {
+            error_count++;
+            log_message(LOG_ERROR, "Failed to queue %zu points for InfluxDB", influx_batch.lines);
+        }
+        lp_buffer_reset(&influx_batch);
+    }
     
-    // Create InfluxDB line protocol format with source tag
-    // Format: measurement,tag_set field_set timestamp
-    snprintf(data, sizeof(data), "environment,sensor=ESP32,source=%s temperature=%.2f,humidity=%.2f", 
-             source, temperature, humidity);
+    http_sink_poll(&influx_sink);
+}
+
+// Start a line of the next batch
+static void begin_influx_line(const lp_prefix_t *prefix) {
+    if (influx_batch.lines == 0) {
+        influx_batch_started = realtime_ms();
+    }
+    lp_line_begin(&influx_batch, prefix);
+}
+
+// Prefix of a series by id, *fresh tells the caller to fill it in
+static lp_prefix_t *series_prefix(uint32_t id, bool *fresh) {
+    static series_prefix_t overflow;
+    uint32_t slot = (id * 2654435761u) % PREFIX_CACHE_SIZE;
     
-    // Reset handle for fresh configuration
-    curl_easy_reset(curl_handle);
+    for (int probe = 0; probe < PREFIX_CACHE_SIZE; probe++) {
+        series_prefix_t *entry = &prefix_cache[(slot + probe) % PREFIX_CACHE_SIZE];
+        if (entry->used && entry->id == id) {
+            *fresh = false;
+            return &entry->prefix;
+        }
+        if (!entry->used) {
+            entry->used = true;
+            entry->id = id;
+            *fresh = true;
+            return &entry->prefix;
+        }
+    }
     
-    // Set URL and headers
-    curl_easy_setopt(curl_handle, CURLOPT_URL, INFLUXDB_WRITE_URL);
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 3L); // Set a timeout to prevent hanging
+    // Cache full, built again every time
+    *fresh = true;
+    return &overflow.prefix;
+}
 
-    // Perform request
-    res = curl_easy_perform(curl_handle);
+// Append the window of one series as an environment_stats point
+static void append_stats_point(const series_aggregate_t *agg, void *context) {
+    (void)context;
+    bool fresh;
+    lp_prefix_t *prefix = series_prefix(agg->key, &fresh);
+    
+    if (fresh) {
+        char device_id[8], window[16];
+        snprintf(device_id, sizeof(device_id), "0x%02X", SERIES_KEY_NODE(agg->key));
+        snprintf(window, sizeof(window), "%ds", STATS_PANE_SEC * STATS_PANES);
+        
+        lp_prefix_init(prefix, "environment_stats");
+        lp_prefix_tag(prefix, "device_id", device_id);
+        lp_prefix_tag(prefix, "field", SERIES_KEY_FIELD(agg->key) == FIELD_TEMPERATURE ? "temperature" : "humidity");
+        lp_prefix_tag(prefix, "sensor", "ESP32");
+        lp_prefix_tag(prefix, "source", SERIES_KEY_ORIGIN(agg->key) == SERIES_ORIGIN_RTU ? "RTU" : "CAN");
+        lp_prefix_tag(prefix, "window", window);
+    }
+    
+    begin_influx_line(prefix);
+    lp_field_int(&influx_batch, "count", agg->count);
+    lp_field_float(&influx_batch, "min", (float)agg->min);
+    lp_field_float(&influx_batch, "max", (float)agg->max);
+    lp_field_float(&influx_batch, "mean", (float)agg->mean);
+    lp_field_float(&influx_batch, "stddev", (float)agg->stddev);
+    lp_field_float(&influx_batch, "p50", (float)agg->p50);
+    lp_field_float(&influx_batch, "p90", (float)agg->p90);
+    lp_field_float(&influx_batch, "p99", (float)agg->p99);
+    if (lp_line_end(&influx_batch, agg->window_end_ms * 1000000)) {
+        stats_points++;
+    }
+}
 
-    if (res == CURLE_OK) {
-        long response_code;
-        curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
-        if (response_code == 204) {
-            write_successful = true;
-            log_message(LOG_INFO, "Successfully wrote %s environmental data to InfluxDB", source);
-        } else {
-            log_message(LOG_ERROR, "Failed to write to InfluxDB: HTTP code %ld", response_code);
-        }
-    } else {
-        log_message(LOG_ERROR, "Failed to write to InfluxDB: %s", curl_easy_strerror(res));
+// Windows of completed panes into the InfluxDB batch
+static void flush_series_statistics(void) {
+    int points = series_stats_advance(&env_stats, realtime_ms(), append_stats_point, NULL);
+    
+    if (points > 0) {
+        log_message(LOG_INFO, "Queued %d environment statistics points for InfluxDB", points);
+    }
+}
+
+// Raw reading into the local history
+static void store_reading(uint32_t key, int64_t timestamp_ms, double value) {
+    if (store.file) {
+        series_store_append(&store, key, timestamp_ms, value);
     }
+}
 
-    return write_successful;
+// One temperature/humidity reading into the statistics windows
+static void add_environment_reading(uint32_t origin, uint8_t node, uint8_t msg_type, float temperature, float humidity) {
+    uint32_t temperature_key = SERIES_KEY(origin, node, msg_type, FIELD_TEMPERATURE);
+    uint32_t humidity_key = SERIES_KEY(origin, node, msg_type, FIELD_HUMIDITY);
+    int64_t now = realtime_ms();
+    
+    series_stats_add(&env_stats, temperature_key, now, temperature);
+    series_stats_add(&env_stats, humidity_key, now, humidity);
+    store_reading(temperature_key, now, temperature);
+    store_reading(humidity_key, now, humidity);
 }
 
-// Write resistor measurements to InfluxDB with the specified format
+// Queue resistor measurements for InfluxDB with the specified format
 bool write_resistor_data_to_influxdb(float v1, float v2, float v3, 
                                      float current, float p1, float p2, float p3, 
-                                     const char *source) {
-    CURLcode res;
-    bool write_successful = false;
-    static char data[512];  // Increased size for more fields
-    float sum_voltage = v1 + v2 + v3;
-    float sum_power = p1 + p2 + p3;
+                                     const char *source, int64_t timestamp_ms) {
+    uint32_t origin = strcmp(source, "RTU") == 0 ? SERIES_ORIGIN_RTU : SERIES_ORIGIN_CAN;
+    bool fresh;
+    lp_prefix_t *prefix = series_prefix(SERIES_KEY(origin, 0, MSG_ELECTRICAL_DC_VOLTAGE, 0), &fresh);
     
     // Calculate individual currents (they should all be the same in a series circuit,
     // but we'll calculate them here for completeness)
     float current_r1 = current;
     float current_r2 = current;
     float current_r3 = current;
-    float sum_current = current_r1 + current_r2 + current_r3;
-    
-    log_message(LOG_DEBUG, "Writing resistor data to InfluxDB - Source: %s", source);
-    
-    // Create InfluxDB line protocol format with source tag and the requested structure
-    // Format: measurement,tag_set field_set timestamp
-    snprintf(data, sizeof(data), 
-             "Analog_Measurement,sensor=ESP32,source=%s "
-             "voltage_r1=%.3f,voltage_r2=%.3f,voltage_r3=%.3f,sum_voltage=%.3f,"
-             "current_r1=%.3f,current_r2=%.3f,current_r3=%.3f,sum_current=%.3f,"
-             "power_r1=%.3f,power_r2=%.3f,power_r3=%.3f,sum_power=%.3f", 
-             source, 
-             v1, v2, v3, sum_voltage,
-             current_r1, current_r2, current_r3, sum_current,
-             p1, p2, p3, sum_power);
     
-    // Reset handle for fresh configuration
-    curl_easy_reset(curl_handle);
+    log_message(LOG_DEBUG, "Queueing resistor data for InfluxDB - Source: %s", source);
     
-    // Set URL and headers
-    curl_easy_setopt(curl_handle, CURLOPT_URL, INFLUXDB_WRITE_URL);
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 3L); // Set a timeout to prevent hanging
-
-    // Perform request
-    res = curl_easy_perform(curl_handle);
-
-    if (res == CURLE_OK) {
-        long response_code;
-        curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
-        if (response_code == 204) {
-            write_successful = true;
-            log_message(LOG_INFO, "Successfully wrote %s resistor data to InfluxDB", source);
-        } else {
-            log_message(LOG_ERROR, "Failed to write resistor data to InfluxDB: HTTP code %ld", response_code);
-        }
-    } else {
-        log_message(LOG_ERROR, "Failed to write resistor data to InfluxDB: %s", curl_easy_strerror(res));
+    if (fresh) {
+        lp_prefix_init(prefix, "Analog_Measurement");
+        lp_prefix_tag(prefix, "sensor", "ESP32");
+        lp_prefix_tag(prefix, "source", source);
     }
-
-    return write_successful;
+    
+    begin_influx_line(prefix);
+    lp_field_float(&influx_batch, "voltage_r1", v1);
+    lp_field_float(&influx_batch, "voltage_r2", v2);
+    lp_field_float(&influx_batch, "voltage_r3", v3);
+    lp_field_float(&influx_batch, "sum_voltage", v1 + v2 + v3);
+    lp_field_float(&influx_batch, "current_r1", current_r1);
+    lp_field_float(&influx_batch, "current_r2", current_r2);
+    lp_field_float(&influx_batch, "current_r3", current_r3);
+    lp_field_float(&influx_batch, "sum_current", current_r1 + current_r2 + current_r3);
+    lp_field_float(&influx_batch, "power_r1", p1);
+    lp_field_float(&influx_batch, "power_r2", p2);
+    lp_field_float(&influx_batch, "power_r3", p3);
+    lp_field_float(&influx_batch, "sum_power", p1 + p2 + p3);
+    return lp_line_end(&influx_batch, timestamp_ms * 1000000);
 }
 
-// Write microphone data to InfluxDB
-bool write_microphone_data_to_influxdb(uint16_t mic_level, uint8_t device_id, const char *source) {
-    CURLcode res;
-    bool write_successful = false;
-    static char data[256];
+// Queue microphone data for InfluxDB
+bool write_microphone_data_to_influxdb(float mic_level, uint8_t device_id, const char *source, int64_t timestamp_ms) {
+    bool fresh;
+    lp_prefix_t *prefix = series_prefix(SERIES_KEY(SERIES_ORIGIN_CAN, device_id, MSG_ENV_MICROPHONE_LEVEL, 0), &fresh);
     
-    log_message(LOG_DEBUG, "Writing microphone data to InfluxDB - Source: %s, Device: 0x%02X, Level: %u", 
+    log_message(LOG_DEBUG, "Queueing microphone data for InfluxDB - Source: %s, Device: 0x%02X, Level: %.1f", 
                 source, device_id, mic_level);
     
-    // Create InfluxDB line protocol format with source and device tags
-    // Format: measurement,tag_set field_set timestamp
-    snprintf(data, sizeof(data), "microphone,sensor=PIC32MX,source=%s,device_id=0x%02X mic_level=%u", 
-             source, device_id, mic_level);
-    
-    // Reset handle for fresh configuration
-    curl_easy_reset(curl_handle);
+    if (fresh) {
+        char device_tag[8];
+        snprintf(device_tag, sizeof(device_tag), "0x%02X", device_id);
+        lp_prefix_init(prefix, "microphone");
+        lp_prefix_tag(prefix, "sensor", "PIC32MX");
+        lp_prefix_tag(prefix, "source", source);
+        lp_prefix_tag(prefix, "device_id", device_tag);
+    }
     
-    // Set URL and headers
-    curl_easy_setopt(curl_handle, CURLOPT_URL, INFLUXDB_WRITE_URL);
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 3L);
+    begin_influx_line(prefix);
+    lp_field_float(&influx_batch, "mic_level", mic_level);
+    return lp_line_end(&influx_batch, timestamp_ms * 1000000);
+}
 
-    // Perform request
-    res = curl_easy_perform(curl_handle);
+// Queue vibration sensor data for InfluxDB
+bool write_vibration_data_to_influxdb(uint8_t vib_state, const char *sensor_id, uint8_t device_id, const char *source,
+                                      int64_t timestamp_ms) {
+    bool fresh;
+    lp_prefix_t *prefix = series_prefix(SERIES_KEY(SERIES_ORIGIN_CAN, device_id, MSG_DIO_INPUT_STATES_INDIVIDUAL, sensor_id[3]),
+                                        &fresh);
+    
+    log_message(LOG_DEBUG, "Queueing vibration data for InfluxDB - Source: %s, Device: 0x%02X, Sensor: %s, State: %u", 
+                source, device_id, sensor_id, vib_state);
+    
+    if (fresh) {
+        char device_tag[8];
+        snprintf(device_tag, sizeof(device_tag), "0x%02X", device_id);
+        lp_prefix_init(prefix, "vibration");
+        lp_prefix_tag(prefix, "sensor", "PIC32MX");
+        lp_prefix_tag(prefix, "source", source);
+        lp_prefix_tag(prefix, "device_id", device_tag);
+        lp_prefix_tag(prefix, "sensor_id", sensor_id);
+    }
+    
+    begin_influx_line(prefix);
+    lp_field_float(&influx_batch, "gpio_state", vib_state);
+    lp_field_bool(&influx_batch, "triggered", vib_state != 0);
+    return lp_line_end(&influx_batch, timestamp_ms * 1000000);
+}
 
-    if (res == CURLE_OK) {
-        long response_code;
-        curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
-        if (response_code == 204) {
-            write_successful = true;
-            log_message(LOG_INFO, "Successfully wrote %s microphone data to InfluxDB", source);
-        } else {
-            log_message(LOG_ERROR, "Failed to write microphone data to InfluxDB: HTTP code %ld", response_code);
+// Microphone level through the swinging door, the kept points to InfluxDB
+static void report_microphone_level(uint8_t device_id, uint16_t mic_value) {
+    uint32_t key = SERIES_KEY(SERIES_ORIGIN_CAN, device_id, MSG_ENV_MICROPHONE_LEVEL, 0);
+    series_compressor_t *c = series_compress_find(&compression, key, &microphone_compression);
+    series_point_t points[2] = { { realtime_ms(), mic_value } };
+    
+    store_reading(key, points[0].timestamp_ms, mic_value);
+    
+    int count = c ? series_compress_add(c, points[0].timestamp_ms, mic_value, points) : 1;
+    
+    for (int i = 0; i < count; i++) {
+        if (!write_microphone_data_to_influxdb((float)points[i].value, device_id, "CAN", points[i].timestamp_ms)) {
+            error_count++;
         }
-    } else {
-        log_message(LOG_ERROR, "Failed to write microphone data to InfluxDB: %s", curl_easy_strerror(res));
     }
-
-    return write_successful;
 }
 
-// Write vibration sensor data to InfluxDB
-bool write_vibration_data_to_influxdb(uint8_t vib_state, const char *sensor_id, uint8_t device_id, const char *source) {
-    CURLcode res;
-    bool write_successful = false;
-    static char data[256];
-    
-    log_message(LOG_DEBUG, "Writing vibration data to InfluxDB - Source: %s, Device: 0x%02X, Sensor: %s, State: %u", 
-                source, device_id, sensor_id, vib_state);
+// Vibration state to InfluxDB when it changes
+static void report_vibration_state(uint8_t device_id, const char *sensor_id, uint8_t vib_state) {
+    uint32_t key = SERIES_KEY(SERIES_ORIGIN_CAN, device_id, MSG_DIO_INPUT_STATES_INDIVIDUAL, sensor_id[3]);
+    series_compressor_t *c = series_compress_find(&compression, key, &vibration_compression);
+    series_point_t points[2] = { { realtime_ms(), vib_state } };
     
-    // Create InfluxDB line protocol format with source, device, and sensor tags
-    // Format: measurement,tag_set field_set timestamp
-    snprintf(data, sizeof(data), "vibration,sensor=PIC32MX,source=%s,device_id=0x%02X,sensor_id=%s gpio_state=%u,triggered=%s", 
-             source, device_id, sensor_id, vib_state, vib_state ? "true" : "false");
+    store_reading(key, points[0].timestamp_ms, vib_state);
     
-    // Reset handle for fresh configuration
-    curl_easy_reset(curl_handle);
+    int count = c ? series_compress_add(c, points[0].timestamp_ms, vib_state, points) : 1;
     
-    // Set URL and headers
-    curl_easy_setopt(curl_handle, CURLOPT_URL, INFLUXDB_WRITE_URL);
-    curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, data);
-    curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, 3L);
-
-    // Perform request
-    res = curl_easy_perform(curl_handle);
-
-    if (res == CURLE_OK) {
-        long response_code;
-        curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &response_code);
-        if (response_code == 204) {
-            write_successful = true;
-            log_message(LOG_INFO, "Successfully wrote %s vibration data to InfluxDB", source);
-        } else {
-            log_message(LOG_ERROR, "Failed to write vibration data to InfluxDB: HTTP code %ld", response_code);
+    for (int i = 0; i < count; i++) {
+        if (!write_vibration_data_to_influxdb((uint8_t)points[i].value, sensor_id, device_id, "CAN", points[i].timestamp_ms)) {
+            error_count++;
         }
-    } else {
-        log_message(LOG_ERROR, "Failed to write vibration data to InfluxDB: %s", curl_easy_strerror(res));
     }
+}
 
-    return write_successful;
+// Resistor record to InfluxDB when any of its fields left the deadband
+static void report_resistor_data(uint32_t origin, uint8_t node, float v1, float v2, float v3,
+                                 float current, float p1, float p2, float p3) {
+    const uint32_t keys[7] = {
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_DC_VOLTAGE, 1),
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_DC_VOLTAGE, 2),
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_DC_VOLTAGE, 3),
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_DC_CURRENT, 0),
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_ACTIVE_POWER, 1),
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_ACTIVE_POWER, 2),
+        SERIES_KEY(origin, node, MSG_ELECTRICAL_ACTIVE_POWER, 3),
+    };
+    const double values[7] = { v1, v2, v3, current, p1, p2, p3 };
+    const char *source = origin == SERIES_ORIGIN_RTU ? "RTU" : "CAN";
+    int64_t now = realtime_ms();
+    
+    for (int i = 0; i < 7; i++) {
+        store_reading(keys[i], now, values[i]);
+    }
+    
+    if (!series_compress_record(&compression, keys, values, 7, &resistor_compression, now)) {
+        return;
+    }
+    
+    if (write_resistor_data_to_influxdb(v1, v2, v3, current, p1, p2, p3, source, now)) {
+        log_message(LOG_DEBUG, "Queued %s resistor data for InfluxDB", source);
+    } else {
+        error_count++;
+    }
 }
 
 // Function to calculate Modbus CRC16
@@ -1180,6 +1350,7 @@ bool read_temperature_humidity_can(int can_socket, float *temperature, float *hu
         
         if (nbytes > 0) {
             can_messages++;
+            can_busload_add(&can_busload, monotonic_ns(), frame.can_id, frame.data, frame.can_dlc, 0);
             
             // Process based on the CAN ID
             switch (frame.can_id) {
@@ -1245,6 +1416,7 @@ void process_all_can_messages(int can_socket) {
             if (nbytes > 0) {
                 can_messages++;
                 messages_processed++;
+                can_busload_add(&can_busload, monotonic_ns(), frame.can_id, frame.data, frame.can_dlc, 0);
                 
                 // Process based on the CAN ID
                 // First check if it's an extended CAN ID
@@ -1301,12 +1473,8 @@ void process_all_can_messages(int can_socket) {
                                 log_message(LOG_DEBUG, "Humidity:    %.2f%%", humid);
                                 log_message(LOG_DEBUG, "--------------------------------------");
                                 
-                                // Write to InfluxDB with source tag "CAN"
-                                if (write_to_influxdb(temp, humid, "CAN")) {
-                                    influx_writes++;
-                                } else {
-                                    error_count++;
-                                }
+                                // Into the statistics windows, written to InfluxDB per pane
+                                add_environment_reading(SERIES_ORIGIN_CAN, source, msg_type, temp, humid);
                                 
                                 // Save to MongoDB - COMMENTED OUT
                                 // save_sensor_data_to_mongodb("extended", source, "Environment", temp, humid);
@@ -1365,14 +1533,8 @@ void process_all_can_messages(int can_socket) {
                                 
                                 // If we have both voltage and current readings, write to InfluxDB
                                 if (last_voltage_read > 0 && last_current_read > 0) {
-                                    if (write_resistor_data_to_influxdb(last_voltage_r1, last_voltage_r2, last_voltage_r3, 
-                                                                    last_current, last_power_r1, last_power_r2, last_power_r3, 
-                                                                    "CAN")) {
-                                        influx_writes++;
-                                        log_message(LOG_DEBUG, "Wrote CAN resistor data to InfluxDB");
-                                    } else {
-                                        error_count++;
-                                        log_message(LOG_ERROR, "Failed to write CAN resistor data to InfluxDB");                                    }
+                                    report_resistor_data(SERIES_ORIGIN_CAN, source, last_voltage_r1, last_voltage_r2, last_voltage_r3,
+                                                         last_current, last_power_r1, last_power_r2, last_power_r3);
                                 }
                             }
                             break;
@@ -1396,12 +1558,8 @@ void process_all_can_messages(int can_socket) {
                                 // Update device activity
                                 update_device_activity(source, "Microphone");
                                 
-                                // Write to InfluxDB
-                                if (write_microphone_data_to_influxdb(mic_value, source, "CAN")) {
-                                    influx_writes++;
-                                } else {
-                                    error_count++;
-                                }
+                                // Write to InfluxDB by exception
+                                report_microphone_level(source, mic_value);
                                 
                                 log_message(LOG_DEBUG, "Microphone sensor data received from device 0x%02X", source);
                             } else {
@@ -1430,12 +1588,8 @@ void process_all_can_messages(int can_socket) {
                                 // Update device activity
                                 update_device_activity(source, "Vibration");
                                 
-                                // Write to InfluxDB
-                                if (write_vibration_data_to_influxdb(vib_state, identifier, source, "CAN")) {
-                                    influx_writes++;
-                                } else {
-                                    error_count++;
-                                }
+                                // Write to InfluxDB on changes of state
+                                report_vibration_state(source, identifier, vib_state);
                                 
                                 // Log vibration events
                                 if (vib_state) {
@@ -1466,12 +1620,8 @@ void process_all_can_messages(int can_socket) {
                                 last_can_humidity = humid;
                                 time(&last_can_read);
                                 
-                                // Write to InfluxDB with source tag "CAN"
-                                if (write_to_influxdb(temp, humid, "CAN")) {
-                                    influx_writes++;
-                                } else {
-                                    error_count++;
-                                }
+                                // Into the statistics windows, written to InfluxDB per pane
+                                add_environment_reading(SERIES_ORIGIN_CAN, 0xFF, MSG_ENV_HUMIDITY, temp, humid);
                                 
                                 // Save to MongoDB
                                 save_sensor_data_to_mongodb("legacy", 0x00, "Environment", temp, humid);
@@ -1497,13 +1647,8 @@ void process_all_can_messages(int can_socket) {
                             
                             // If we have both voltage and current readings, write to InfluxDB
                             if (last_voltage_read > 0 && last_current_read > 0) {
-                                if (write_resistor_data_to_influxdb(last_voltage_r1, last_voltage_r2, last_voltage_r3, 
-                                                                last_current, last_power_r1, last_power_r2, last_power_r3, 
-                                                                "CAN")) {
-                                    influx_writes++;
-                                } else {
-                                    error_count++;
-                                }
+                                report_resistor_data(SERIES_ORIGIN_CAN, 0xFF, last_voltage_r1, last_voltage_r2, last_voltage_r3,
+                                                     last_current, last_power_r1, last_power_r2, last_power_r3);
                             }
                             break;
                         default:
@@ -1526,6 +1671,30 @@ void process_all_can_messages(int can_socket) {
     }
 }
 
+// Name of a series message type in the statistics
+static const char *series_type_name(uint8_t msg_type) {
+    switch (msg_type) {
+        case MSG_TEMP_AMBIENT:                return "temperature";
+        case MSG_ENV_HUMIDITY:                return "humidity";
+        case MSG_ELECTRICAL_DC_VOLTAGE:       return "voltage";
+        case MSG_ELECTRICAL_DC_CURRENT:       return "current";
+        case MSG_ELECTRICAL_ACTIVE_POWER:     return "power";
+        case MSG_ENV_MICROPHONE_LEVEL:        return "microphone";
+        case MSG_DIO_INPUT_STATES_INDIVIDUAL: return "vibration";
+        default:                              return "other";
+    }
+}
+
+// Name of a series, temperature and humidity share the environment types
+static const char *series_field_name(uint32_t key) {
+    uint8_t msg_type = SERIES_KEY_TYPE(key);
+    
+    if (msg_type == MSG_TEMP_AMBIENT || msg_type == MSG_ENV_HUMIDITY) {
+        return SERIES_KEY_FIELD(key) == FIELD_TEMPERATURE ? "temperature" : "humidity";
+    }
+    return series_type_name(msg_type);
+}
+
 // Print statistics
 void print_statistics() {
     log_message(LOG_INFO, "\n======================================");
@@ -1534,7 +1703,18 @@ void print_statistics() {
     log_message(LOG_INFO, "Modbus RTU Queries Sent:     %lu", modbus_queries);
     log_message(LOG_INFO, "Modbus RTU Replies Received: %lu", modbus_replies);
     log_message(LOG_INFO, "CAN Messages Received:       %lu", can_messages);
-    log_message(LOG_INFO, "InfluxDB Writes:            %lu", influx_writes);
+    log_message(LOG_INFO, "InfluxDB Lines Written:     %lu", influx_lines_written);
+    log_message(LOG_INFO, "Statistics Points Written:  %lu", stats_points);
+    log_message(LOG_INFO, "InfluxDB Batches:           %llu acked, %llu retries, %llu failed, %llu dropped",
+                (unsigned long long)influx_sink.stats.acked, (unsigned long long)influx_sink.stats.retries,
+                (unsigned long long)influx_sink.stats.failed, (unsigned long long)influx_sink.stats.dropped);
+    log_message(LOG_INFO, "MongoDB Sensor Readings:    %llu in %llu bucket writes, %llu bulk errors, %llu lost, %u dropped",
+                (unsigned long long)mongo_buckets.readings, (unsigned long long)mongo_buckets.upserts,
+                (unsigned long long)mongo_buckets.errors, (unsigned long long)mongo_buckets.lost,
+                mongo_buckets.dropped);
+    log_message(LOG_INFO, "InfluxDB Bytes:             %llu raw, %llu gzip, %llu on the wire",
+                (unsigned long long)influx_sink.stats.raw_bytes, (unsigned long long)influx_sink.stats.body_bytes,
+                (unsigned long long)influx_sink.stats.wire_bytes);
     log_message(LOG_INFO, "Errors:                     %lu", error_count);
     
     float modbus_success = (modbus_replies > 0 && modbus_queries > 0) ? 
@@ -1542,6 +1722,31 @@ void print_statistics() {
     
     log_message(LOG_INFO, "Modbus RTU Success Rate:    %.1f%%", modbus_success);
     
+    // Bus load over the last minute, exact and with worst case bit stuffing
+    can_busload_t load;
+    can_busload_read(&can_busload, monotonic_ns(), &load);
+    log_message(LOG_INFO, "CAN Bus Load (%u bit/s):  %.2f%% (worst case %.2f%%)", can_busload.bitrate, load.total, load.worst);
+    log_message(LOG_INFO, "  Emergency/High/Normal:    %.2f%% / %.2f%% / %.2f%%",
+                load.classes[CAN_BUSLOAD_CLASS_EMERGENCY], load.classes[CAN_BUSLOAD_CLASS_HIGH],
+                load.classes[CAN_BUSLOAD_CLASS_NORMAL]);
+    log_message(LOG_INFO, "  Low/Background/Standard:  %.2f%% / %.2f%% / %.2f%%",
+                load.classes[CAN_BUSLOAD_CLASS_LOW], load.classes[CAN_BUSLOAD_CLASS_BACKGROUND],
+                load.classes[CAN_BUSLOAD_CLASS_STANDARD]);
+    
+    // Readings per written point of every compressed series
+    log_message(LOG_INFO, "\n======================================");
+    log_message(LOG_INFO, "        COMPRESSION");
+    log_message(LOG_INFO, "======================================");
+    for (int i = 0; i < SERIES_COMPRESS_MAX; i++) {
+        const series_compressor_t *c = &compression.series[i];
+        if (c->used) {
+            log_message(LOG_INFO, "[%s 0x%02X] %-10s %3u: %llu readings, %llu written, %.1f:1",
+                        SERIES_KEY_ORIGIN(c->key) == SERIES_ORIGIN_RTU ? "RTU" : "CAN", SERIES_KEY_NODE(c->key),
+                        series_type_name(SERIES_KEY_TYPE(c->key)), SERIES_KEY_FIELD(c->key),
+                        (unsigned long long)c->samples, (unsigned long long)c->points, series_compress_ratio(c));
+        }
+    }
+    
     // Print device status
     log_message(LOG_INFO, "\n======================================");
     log_message(LOG_INFO, "        DEVICE STATUS");
@@ -1558,6 +1763,21 @@ void print_statistics() {
     log_message(LOG_INFO, "[CAN] Temperature: %.2f°C", last_can_temperature);
     log_message(LOG_INFO, "[CAN] Humidity:    %.2f%%", last_can_humidity);
     
+    // Latest complete window of every environment series
+    log_message(LOG_INFO, "-------------------------------------");
+    log_message(LOG_INFO, "Last %ds windows (%llu raw readings, %u dropped):", STATS_PANE_SEC * STATS_PANES,
+                (unsigned long long)env_stats.raw.written, env_stats.dropped);
+    for (int i = 0; i < SERIES_MAX; i++) {
+        series_aggregate_t agg;
+        if (env_stats.series[i].used && env_stats.started &&
+            series_stats_window(&env_stats, &env_stats.series[i], env_stats.last_epoch, &agg)) {
+            log_message(LOG_INFO, "[%s 0x%02X] %-11s n=%u mean=%.2f sd=%.2f min=%.2f p50=%.2f p99=%.2f max=%.2f",
+                        SERIES_KEY_ORIGIN(agg.key) == SERIES_ORIGIN_RTU ? "RTU" : "CAN", SERIES_KEY_NODE(agg.key),
+                        SERIES_KEY_FIELD(agg.key) == FIELD_TEMPERATURE ? "temperature" : "humidity",
+                        agg.count, agg.mean, agg.stddev, agg.min, agg.p50, agg.p99, agg.max);
+        }
+    }
+    
     // Resistor data - separate RTU measurements
     log_message(LOG_INFO, "\n======================================");
     log_message(LOG_INFO, "        RTU RESISTOR MEASUREMENTS");
@@ -1582,6 +1802,48 @@ void print_statistics() {
     log_message(LOG_INFO, "Power R2:  %.3f mW", last_power_r2 * 1000.0);
     log_message(LOG_INFO, "Power R3:  %.3f mW", last_power_r3 * 1000.0);
     
+    // Local history of every series, with its last hour
+    log_message(LOG_INFO, "\n======================================");
+    log_message(LOG_INFO, "        LOCAL HISTORY");
+    log_message(LOG_INFO, "======================================");
+    if (store.file) {
+        int64_t now = realtime_ms();
+        
+        for (int i = 0; i < SERIES_STORE_MAX_SERIES; i++) {
+            const series_store_series_t *series = &store.series[i];
+            series_store_bucket_t hour;
+            int64_t oldest;
+            uint64_t bytes;
+            char oldest_buffer[30];
+            
+            if (!series->used || !series_store_info(&store, series->key, &oldest, &bytes)) {
+                continue;
+            }
+            
+            time_t oldest_sec = (time_t)(oldest / 1000);
+            strftime(oldest_buffer, sizeof(oldest_buffer), "%Y-%m-%d %H:%M:%S", localtime(&oldest_sec));
+            
+            if (series_store_downsample(&store, series->key, now - 3600000, now, 3600000, &hour, 1)) {
+                log_message(LOG_INFO, "[%s 0x%02X] %-11s %3u: %llu since %s, %.1f B each, last hour %.3f / %.3f / %.3f",
+                            SERIES_KEY_ORIGIN(series->key) == SERIES_ORIGIN_RTU ? "RTU" : "CAN", SERIES_KEY_NODE(series->key),
+                            series_field_name(series->key), SERIES_KEY_FIELD(series->key),
+                            (unsigned long long)series->points, oldest_buffer, (double)bytes / series->points,
+                            hour.min, hour.sum / hour.count, hour.max);
+            } else {
+                log_message(LOG_INFO, "[%s 0x%02X] %-11s %3u: %llu since %s, %.1f B each",
+                            SERIES_KEY_ORIGIN(series->key) == SERIES_ORIGIN_RTU ? "RTU" : "CAN", SERIES_KEY_NODE(series->key),
+                            series_field_name(series->key), SERIES_KEY_FIELD(series->key),
+                            (unsigned long long)series->points, oldest_buffer, (double)bytes / series->points);
+            }
+        }
+        if (store.dropped) {
+            log_message(LOG_WARNING, "Readings not stored: %u", store.dropped);
+        }
+        series_store_sync(&store);
+    } else {
+        log_message(LOG_INFO, "Not available");
+    }
+    
     // Last successful reads timestamps
     log_message(LOG_INFO, "\n======================================");
     log_message(LOG_INFO, "        LAST SUCCESSFUL READS");
@@ -1652,7 +1914,8 @@ int main(void) {
     
     database = mongoc_client_get_database(mongo_client, "canbus_data");
     devices_collection = mongoc_database_get_collection(database, "devices");
-    sensors_collection = mongoc_database_get_collection(database, "sensor_readings");
+    sensors_collection = mongoc_database_get_collection(database, "sensor_buckets");
+    mongo_bucket_init(&mongo_buckets, sensors_collection, MONGO_BUCKET_MS);
     
     log_message(LOG_INFO, "MongoDB connection established");
     
@@ -1680,6 +1943,14 @@ int main(void) {
         return EXIT_FAILURE;
     }
     
+    if (!init_influx_sink()) {
+        log_message(LOG_ERROR, "Failed to initialize the InfluxDB writer");
+        cleanup_curl_resources();
+        curl_global_cleanup();
+        gpioTerminate();
+        return EXIT_FAILURE;
+    }
+    
     // Test InfluxDB connection
     if (!test_influxdb_connection()) {
         log_message(LOG_WARNING, "Failed to connect to InfluxDB. Will continue but data won't be stored.");
@@ -1755,8 +2026,32 @@ int main(void) {
     log_message(LOG_INFO, "      INITIALIZING CAN INTERFACE");
     log_message(LOG_INFO, "======================================");
     log_message(LOG_INFO, "Interface:  %s", CAN_INTERFACE);
+    log_message(LOG_INFO, "Bit rate:   %d", CAN_BITRATE);
     log_message(LOG_INFO, "Socket:     PF_CAN / SOCK_RAW");
     
+    can_busload_init(&can_busload, CAN_BITRATE, 0);
+    
+    if (!series_stats_init(&env_stats, STATS_PANE_SEC * 1000, STATS_PANES, STATS_RAW_SAMPLES)) {
+        log_message(LOG_ERROR, "Failed to set up the environment statistics");
+        close(serial_fd);
+        cleanup_resources();
+        return EXIT_FAILURE;
+    }
+    
+    if (!lp_buffer_init(&influx_batch, 4096)) {
+        log_message(LOG_ERROR, "Failed to allocate the InfluxDB batch buffer");
+        close(serial_fd);
+        cleanup_resources();
+        return EXIT_FAILURE;
+    }
+    
+    // Local history is optional, the gateway runs on without it
+    if (series_store_open(&store, STORE_PATH, STORE_BLOCKS)) {
+        log_message(LOG_INFO, "Local history: %s, %u blocks", STORE_PATH, STORE_BLOCKS);
+    } else {
+        log_message(LOG_WARNING, "Local history not available: %s: %s", STORE_PATH, strerror(errno));
+    }
+    
     // Create CAN socket
     struct sockaddr_can addr;
     struct ifreq ifr;
@@ -1807,6 +2102,7 @@ int main(void) {
     log_message(LOG_INFO, "Press Ctrl+C to exit");
     
     time_t last_stats_time = 0;
+    time_t last_bucket_flush = 0;
     time_t last_rtu_resistor_time = 0;
     time_t current_time;
     float rtu_temperature, rtu_humidity;
@@ -1830,28 +2126,18 @@ int main(void) {
             last_rtu_humidity = rtu_humidity;
             time(&last_rtu_read);
             
-            // Write to InfluxDB with source tag "RTU"
-            log_message(LOG_DEBUG, "Writing RTU data to InfluxDB...");
-            if (write_to_influxdb(rtu_temperature, rtu_humidity, "RTU")) {
-                influx_writes++;
-            } else {
-                error_count++;
-            }
+            // Into the statistics windows, written to InfluxDB per pane
+            add_environment_reading(SERIES_ORIGIN_RTU, SLAVE_ID, MSG_TEMP_AMBIENT, rtu_temperature, rtu_humidity);
         }
         
         // Read resistor data via Modbus RTU every 5 seconds
         time(&current_time);
         if (current_time - last_rtu_resistor_time >= 5) {
             if (read_resistor_data_rtu(serial_fd, SERIAL_COMMUNICATION_CONTROL_PIN)) {
-                // Write resistor data to InfluxDB
-                if (write_resistor_data_to_influxdb(
-                        last_rtu_voltage_r1, last_rtu_voltage_r2, last_rtu_voltage_r3,
-                        last_rtu_current, last_rtu_power_r1, last_rtu_power_r2, last_rtu_power_r3,
-                        "RTU")) {
-                    influx_writes++;
-                } else {
-                    error_count++;
-                }
+                // Write resistor data to InfluxDB by exception
+                report_resistor_data(SERIES_ORIGIN_RTU, SLAVE_ID,
+                                     last_rtu_voltage_r1, last_rtu_voltage_r2, last_rtu_voltage_r3,
+                                     last_rtu_current, last_rtu_power_r1, last_rtu_power_r2, last_rtu_power_r3);
                 last_rtu_resistor_time = current_time;
             }
         }
@@ -1859,6 +2145,18 @@ int main(void) {
         // Process CAN messages (both environment and resistor data)
         process_all_can_messages(can_socket);
         
+        // Environment statistics of the panes completed since the last pass
+        flush_series_statistics();
+        
+        // Send the InfluxDB batch when due, collect write acknowledgements
+        flush_influx_batch(false);
+        
+        // Pending MongoDB sensor readings, one bulk for all series
+        if (current_time - last_bucket_flush >= MONGO_FLUSH_SEC) {
+            flush_sensor_buckets();
+            last_bucket_flush = current_time;
+        }
+        
         // Print statistics once per minute
         if (current_time - last_stats_time >= 60) {
             print_statistics();
@@ -1876,12 +2174,21 @@ int main(void) {
     
     // Clean up
     log_message(LOG_INFO, "Shutting down...");
+    flush_influx_batch(true);
+    if (http_sink_drain(&influx_sink, 5000) > 0) {
+        log_message(LOG_WARNING, "InfluxDB batches still unacknowledged at shutdown");
+    }
+    flush_sensor_buckets();
     close(serial_fd);
     close(can_socket);
     cleanup_resources();
     
     // Final statistics
     print_statistics();
+    series_stats_free(&env_stats);
+    series_store_close(&store);
+    lp_buffer_free(&influx_batch);
+    mongo_bucket_free(&mongo_buckets);
     log_message(LOG_INFO, "Monitor terminated successfully");
     
     return EXIT_SUCCESS;
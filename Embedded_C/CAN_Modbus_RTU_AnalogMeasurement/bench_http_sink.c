@@ -0,0 +1,310 @@
+/**
+ * @file bench_http_sink.c
+ * @brief Writes per second and bytes on the wire of http_sink.h
+ *
+ * Starts a local stand-in for the InfluxDB write endpoint - keep-alive
+ * HTTP/1.1, gunzips the body, counts the lines, answers 204 after a fixed
+ * service time - and sends the same line protocol batches of the gateway
+ * through:
+ *
+ *   blocking     curl_easy_reset() and options before every perform, the
+ *                way Main.c wrote before, with 1 and with 100 lines per write
+ *   sink         http_sink.h, identity and gzip, 1 and 4 requests in flight
+ *
+ * A last run answers every 7th request with 503 and checks that the
+ * retries still deliver every line exactly once.
+ *
+ * Build: gcc -O2 -o bench_http_sink bench_http_sink.c -lcurl -lz -lpthread -lm
+ * Usage: ./bench_http_sink [lines] [service_us]
+ */
+
+#define _GNU_SOURCE                         // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "line_protocol.h"
+#include "http_sink.h"
+
+#define BENCH_BATCH_LINES 100
+#define BENCH_REQUEST_MAX (1 << 20)
+
+static int service_us = 2000;
+static int fail_every = 0;
+static atomic_ulong requests;
+static atomic_ulong connections;
+static atomic_ulong lines_received;
+static atomic_ulong bytes_received;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long count_lines(const uint8_t *body, size_t len, bool gzip, uint8_t *scratch) {
+    unsigned long lines = 0;
+
+    if (gzip) {
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        inflateInit2(&z, 15 + 16);
+        z.next_in = (Bytef *)body;
+        z.avail_in = (uInt)len;
+        z.next_out = scratch;
+        z.avail_out = BENCH_REQUEST_MAX;
+        inflate(&z, Z_FINISH);
+        body = scratch;
+        len = z.total_out;
+        inflateEnd(&z);
+    }
+    for (size_t i = 0; i < len; i++) {
+        lines += body[i] == '\n';
+    }
+    return lines;
+}
+
+// One keep-alive connection of the stand-in
+static void *serve_connection(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    uint8_t *buf = malloc(BENCH_REQUEST_MAX);
+    uint8_t *scratch = malloc(BENCH_REQUEST_MAX);
+    size_t have = 0;
+
+    for (;;) {
+        char *end = NULL;
+        while (!(end = memmem(buf, have, "\r\n\r\n", 4))) {
+            ssize_t n = read(fd, buf + have, BENCH_REQUEST_MAX - have);
+            if (n <= 0) goto done;
+            have += n;
+        }
+
+        size_t header_len = (uint8_t *)end + 4 - buf;
+        size_t body_len = 0;
+        bool gzip = memmem(buf, header_len, "Content-Encoding: gzip", 22) != NULL;
+        char *cl = memmem(buf, header_len, "Content-Length: ", 16);
+        if (cl) body_len = strtoul(cl + 16, NULL, 10);
+
+        while (have < header_len + body_len) {
+            ssize_t n = read(fd, buf + have, BENCH_REQUEST_MAX - have);
+            if (n <= 0) goto done;
+            have += n;
+        }
+
+        unsigned long n = atomic_fetch_add(&requests, 1) + 1;
+        atomic_fetch_add(&bytes_received, header_len + body_len);
+        usleep(service_us);
+
+        const char *answer = "HTTP/1.1 204 No Content\r\n\r\n";
+        if (fail_every && n % fail_every == 0) {
+            answer = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+        } else {
+            atomic_fetch_add(&lines_received, count_lines(buf + header_len, body_len, gzip, scratch));
+        }
+        if (write(fd, answer, strlen(answer)) < 0) goto done;
+
+        memmove(buf, buf + header_len + body_len, have - header_len - body_len);
+        have -= header_len + body_len;
+    }
+
+done:
+    close(fd);
+    free(buf);
+    free(scratch);
+    return NULL;
+}
+
+static void *serve(void *arg) {
+    int listener = (int)(intptr_t)arg;
+
+    for (;;) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        pthread_t thread;
+        atomic_fetch_add(&connections, 1);
+        pthread_create(&thread, NULL, serve_connection, (void *)(intptr_t)fd);
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+// Batches of the gateway's points, one line protocol body each
+static void build_batch(lp_buffer_t *buf, uint32_t first, uint32_t lines) {
+    static lp_prefix_t resistor, mic, stats;
+    if (!resistor.len) {
+        lp_prefix_init(&resistor, "Analog_Measurement");
+        lp_prefix_tag(&resistor, "sensor", "ESP32");
+        lp_prefix_tag(&resistor, "source", "RTU");
+        lp_prefix_init(&mic, "microphone");
+        lp_prefix_tag(&mic, "sensor", "PIC32MX");
+        lp_prefix_tag(&mic, "source", "CAN");
+        lp_prefix_tag(&mic, "device_id", "0x30");
+        lp_prefix_init(&stats, "environment_stats");
+        lp_prefix_tag(&stats, "device_id", "0x21");
+        lp_prefix_tag(&stats, "field", "temperature");
+        lp_prefix_tag(&stats, "sensor", "ESP32");
+        lp_prefix_tag(&stats, "source", "CAN");
+        lp_prefix_tag(&stats, "window", "60s");
+    }
+
+    lp_buffer_reset(buf);
+    for (uint32_t i = first; i < first + lines; i++) {
+        int64_t ts = (1700000000000LL + i * 100LL) * 1000000;
+        float v = 1.0f + (float)(i % 997) / 1000.0f;
+        switch (i % 3) {
+        case 0:
+            lp_line_begin(buf, &resistor);
+            lp_field_float(buf, "voltage_r1", v);
+            lp_field_float(buf, "voltage_r2", v * 2);
+            lp_field_float(buf, "voltage_r3", v * 3);
+            lp_field_float(buf, "sum_voltage", v * 6);
+            lp_field_float(buf, "current_r1", 0.012f);
+            lp_field_float(buf, "power_r1", v * 0.012f);
+            break;
+        case 1:
+            lp_line_begin(buf, &mic);
+            lp_field_float(buf, "mic_level", (float)(i % 1024));
+            break;
+        default:
+            lp_line_begin(buf, &stats);
+            lp_field_int(buf, "count", 600);
+            lp_field_float(buf, "min", v + 20.0f);
+            lp_field_float(buf, "max", v + 21.0f);
+            lp_field_float(buf, "mean", v + 20.5f);
+            lp_field_float(buf, "p99", v + 20.9f);
+            break;
+        }
+        lp_line_end(buf, ts);
+    }
+}
+
+static void reset_counters(void) {
+    atomic_store(&requests, 0);
+    atomic_store(&connections, 0);
+    atomic_store(&lines_received, 0);
+    atomic_store(&bytes_received, 0);
+}
+
+// Requests as received by the stand-in, headers and bodies
+static void report(const char *name, uint32_t lines, double elapsed) {
+    printf("%-28s %5.0f writes/s %7.0f lines/s %6.1f B/line sent, %lu conn, %lu of %u lines\n", name,
+           atomic_load(&requests) / elapsed, lines / elapsed, (double)atomic_load(&bytes_received) / lines,
+           atomic_load(&connections),
+           atomic_load(&lines_received), lines);
+}
+
+static void run_blocking(const char *url, uint32_t lines, uint32_t per_write) {
+    lp_buffer_t buf;
+    CURL *curl = curl_easy_init();
+    struct curl_slist *headers = curl_slist_append(NULL, "Content-Type: text/plain; charset=utf-8");
+    char name[64];
+
+    lp_buffer_init(&buf, 4096);
+    reset_counters();
+    double start = now_seconds();
+    for (uint32_t i = 0; i < lines; i += per_write) {
+        build_batch(&buf, i, per_write);
+        curl_easy_reset(curl);
+        curl_easy_setopt(curl, CURLOPT_URL, url);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, buf.data);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, http_sink_discard);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 3L);
+        curl_easy_perform(curl);
+    }
+    double elapsed = now_seconds() - start;
+
+    snprintf(name, sizeof(name), "blocking %u line%s", per_write, per_write > 1 ? "s" : "");
+    report(name, lines, elapsed);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    lp_buffer_free(&buf);
+}
+
+static bool run_sink(const char *url, uint32_t lines, http_sink_encoding_t encoding, int inflight) {
+    static http_sink_t sink;
+    lp_buffer_t buf;
+    struct curl_slist *headers = curl_slist_append(NULL, "Content-Type: text/plain; charset=utf-8");
+    http_sink_config_t config = {
+        .url = url, .headers = headers, .inflight = inflight, .encoding = encoding,
+        .max_attempts = 5, .retry_ms = 10, .timeout_ms = 3000,
+    };
+    char name[64];
+
+    if (!http_sink_init(&sink, &config)) {
+        fprintf(stderr, "http_sink_init failed\n");
+        return false;
+    }
+    lp_buffer_init(&buf, 4096);
+    reset_counters();
+
+    double start = now_seconds();
+    for (uint32_t i = 0; i < lines; i += BENCH_BATCH_LINES) {
+        build_batch(&buf, i, BENCH_BATCH_LINES);
+        // Keep the queue short of full, nothing may be dropped here
+        while (http_sink_poll(&sink) >= HTTP_SINK_QUEUE - 1) {
+            curl_multi_poll(sink.multi, NULL, 0, 1, NULL);
+        }
+        http_sink_send(&sink, buf.data, buf.len, (uint32_t)buf.lines);
+    }
+    int left = http_sink_drain(&sink, 10000);
+    double elapsed = now_seconds() - start;
+
+    snprintf(name, sizeof(name), "sink %s, %d in flight%s", encoding == HTTP_SINK_GZIP ? "gzip" : "identity", inflight,
+             fail_every ? ", 503s" : "");
+    report(name, lines, elapsed);
+    printf("%28s body %.1f%% of raw, %llu acked, %llu retries, %llu failed, %llu dropped, %llu B on the wire\n",
+           "", 100.0 * sink.stats.body_bytes / sink.stats.raw_bytes, (unsigned long long)sink.stats.acked,
+           (unsigned long long)sink.stats.retries, (unsigned long long)sink.stats.failed,
+           (unsigned long long)sink.stats.dropped, (unsigned long long)sink.stats.wire_bytes);
+
+    bool complete = left == 0 && sink.stats.lines_acked == lines && atomic_load(&lines_received) == lines;
+    http_sink_cleanup(&sink);
+    curl_slist_free_all(headers);
+    lp_buffer_free(&buf);
+    return complete;
+}
+
+int main(int argc, char **argv) {
+    uint32_t lines = argc > 1 ? (uint32_t)atoi(argv[1]) : 100000;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+    char url[128];
+    pthread_t server;
+    bool ok = true;
+
+    service_us = argc > 2 ? atoi(argv[2]) : 2000;
+    lines -= lines % BENCH_BATCH_LINES;
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, 16) < 0) {
+        perror("listen");
+        return EXIT_FAILURE;
+    }
+    getsockname(listener, (struct sockaddr *)&addr, &addr_len);
+    snprintf(url, sizeof(url), "http://127.0.0.1:%u/api/v2/write?bucket=bench&precision=ns", ntohs(addr.sin_port));
+    pthread_create(&server, NULL, serve, (void *)(intptr_t)listener);
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    printf("%u lines, %d us service time per request\n", lines, service_us);
+
+    run_blocking(url, lines / 10, 1);       // a tenth, one request per line takes long
+    run_blocking(url, lines, BENCH_BATCH_LINES);
+    ok &= run_sink(url, lines, HTTP_SINK_IDENTITY, 1);
+    ok &= run_sink(url, lines, HTTP_SINK_GZIP, 1);
+    ok &= run_sink(url, lines, HTTP_SINK_IDENTITY, 4);
+    ok &= run_sink(url, lines, HTTP_SINK_GZIP, 4);
+    fail_every = 7;
+    ok &= run_sink(url, lines, HTTP_SINK_GZIP, 4);
+
+    printf("delivery: %s\n", ok ? "every line exactly once" : "LINES MISSING OR DUPLICATED");
+    curl_global_cleanup();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
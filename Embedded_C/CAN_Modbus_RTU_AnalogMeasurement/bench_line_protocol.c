@@ -0,0 +1,191 @@
+/**
+ * @file bench_line_protocol.c
+ * @brief Lines per second of line_protocol.h against the snprintf lines
+ *
+ * Builds the environment statistics, resistor and microphone points of the
+ * gateway both ways, 100 lines per write as in a batched flush, and checks
+ * that every number of the builder reads back to the value it was given:
+ *
+ *   snprintf     one snprintf() per line, fixed decimals, tags every time
+ *   builder      cached prefix, shortest round trip numbers, reused buffer
+ *
+ * Build: gcc -O2 -o bench_line_protocol bench_line_protocol.c -lm
+ * Usage: ./bench_line_protocol [lines]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "line_protocol.h"
+
+#define BENCH_BATCH 100
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Readings at the resolution of the sensors
+static float reading(uint32_t n, float base, float step) {
+    return base + (float)((n * 2654435761u) % 2001) * step;
+}
+
+static void report(const char *name, uint32_t lines, double elapsed, size_t bytes) {
+    printf("%-22s %9.0f lines/s  %6.1f bytes/line\n", name, lines / elapsed, (double)bytes / lines);
+}
+
+int main(int argc, char **argv) {
+    uint32_t lines = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000000;
+    static char batch[BENCH_BATCH * 512];
+    lp_buffer_t buf;
+    lp_prefix_t stats_prefix, resistor_prefix, mic_prefix;
+    int64_t ts = 1700000000000LL * 1000000;
+    double start, elapsed;
+    size_t bytes;
+    uint32_t errors = 0;
+
+    if (!lp_buffer_init(&buf, 4096)) {
+        return EXIT_FAILURE;
+    }
+
+    lp_prefix_init(&stats_prefix, "environment_stats");
+    lp_prefix_tag(&stats_prefix, "device_id", "0x21");
+    lp_prefix_tag(&stats_prefix, "field", "temperature");
+    lp_prefix_tag(&stats_prefix, "sensor", "ESP32");
+    lp_prefix_tag(&stats_prefix, "source", "CAN");
+    lp_prefix_tag(&stats_prefix, "window", "60s");
+    lp_prefix_init(&resistor_prefix, "Analog_Measurement");
+    lp_prefix_tag(&resistor_prefix, "sensor", "ESP32");
+    lp_prefix_tag(&resistor_prefix, "source", "RTU");
+    lp_prefix_init(&mic_prefix, "microphone");
+    lp_prefix_tag(&mic_prefix, "sensor", "PIC32MX");
+    lp_prefix_tag(&mic_prefix, "source", "CAN");
+    lp_prefix_tag(&mic_prefix, "device_id", "0x30");
+
+    // Environment statistics
+    bytes = 0;
+    start = now_seconds();
+    for (uint32_t n = 0; n < lines; n += BENCH_BATCH) {
+        size_t len = 0;
+        for (uint32_t i = n; i < n + BENCH_BATCH; i++) {
+            float t = reading(i, 15.0f, 0.01f);
+            len += snprintf(batch + len, sizeof(batch) - len,
+                            "environment_stats,sensor=ESP32,source=%s,device_id=0x%02X,field=%s,window=%ds "
+                            "count=%ui,min=%.2f,max=%.2f,mean=%.3f,stddev=%.3f,p50=%.2f,p90=%.2f,p99=%.2f %lld\n",
+                            "CAN", 0x21, "temperature", 60, 600u, t - 1.0f, t + 1.0f, t, 0.25f, t, t + 0.5f,
+                            t + 0.9f, (long long)(ts + i));
+        }
+        bytes += len;
+    }
+    report("stats snprintf", lines, now_seconds() - start, bytes);
+
+    bytes = 0;
+    start = now_seconds();
+    for (uint32_t n = 0; n < lines; n += BENCH_BATCH) {
+        lp_buffer_reset(&buf);
+        for (uint32_t i = n; i < n + BENCH_BATCH; i++) {
+            float t = reading(i, 15.0f, 0.01f);
+            lp_line_begin(&buf, &stats_prefix);
+            lp_field_int(&buf, "count", 600);
+            lp_field_float(&buf, "min", t - 1.0f);
+            lp_field_float(&buf, "max", t + 1.0f);
+            lp_field_float(&buf, "mean", t);
+            lp_field_float(&buf, "stddev", 0.25f);
+            lp_field_float(&buf, "p50", t);
+            lp_field_float(&buf, "p90", t + 0.5f);
+            lp_field_float(&buf, "p99", t + 0.9f);
+            lp_line_end(&buf, ts + i);
+        }
+        bytes += buf.len;
+    }
+    report("stats builder", lines, now_seconds() - start, bytes);
+
+    // Resistor divider, twelve fields
+    bytes = 0;
+    start = now_seconds();
+    for (uint32_t n = 0; n < lines; n += BENCH_BATCH) {
+        size_t len = 0;
+        for (uint32_t i = n; i < n + BENCH_BATCH; i++) {
+            float v = reading(i, 1.0f, 0.001f), c = reading(i, 0.01f, 0.00001f);
+            len += snprintf(batch + len, sizeof(batch) - len,
+                            "Analog_Measurement,sensor=ESP32,source=%s "
+                            "voltage_r1=%.3f,voltage_r2=%.3f,voltage_r3=%.3f,sum_voltage=%.3f,"
+                            "current_r1=%.3f,current_r2=%.3f,current_r3=%.3f,sum_current=%.3f,"
+                            "power_r1=%.3f,power_r2=%.3f,power_r3=%.3f,sum_power=%.3f %lld\n",
+                            "RTU", v, v * 2, v * 3, v * 6, c, c, c, c * 3, v * c, v * c * 2, v * c * 3, v * c * 6,
+                            (long long)(ts + i));
+        }
+        bytes += len;
+    }
+    report("resistor snprintf", lines, now_seconds() - start, bytes);
+
+    bytes = 0;
+    start = now_seconds();
+    for (uint32_t n = 0; n < lines; n += BENCH_BATCH) {
+        lp_buffer_reset(&buf);
+        for (uint32_t i = n; i < n + BENCH_BATCH; i++) {
+            float v = reading(i, 1.0f, 0.001f), c = reading(i, 0.01f, 0.00001f);
+            lp_line_begin(&buf, &resistor_prefix);
+            lp_field_float(&buf, "voltage_r1", v);
+            lp_field_float(&buf, "voltage_r2", v * 2);
+            lp_field_float(&buf, "voltage_r3", v * 3);
+            lp_field_float(&buf, "sum_voltage", v * 6);
+            lp_field_float(&buf, "current_r1", c);
+            lp_field_float(&buf, "current_r2", c);
+            lp_field_float(&buf, "current_r3", c);
+            lp_field_float(&buf, "sum_current", c * 3);
+            lp_field_float(&buf, "power_r1", v * c);
+            lp_field_float(&buf, "power_r2", v * c * 2);
+            lp_field_float(&buf, "power_r3", v * c * 3);
+            lp_field_float(&buf, "sum_power", v * c * 6);
+            lp_line_end(&buf, ts + i);
+        }
+        bytes += buf.len;
+    }
+    report("resistor builder", lines, now_seconds() - start, bytes);
+
+    // Microphone level, one field
+    bytes = 0;
+    start = now_seconds();
+    for (uint32_t n = 0; n < lines; n += BENCH_BATCH) {
+        size_t len = 0;
+        for (uint32_t i = n; i < n + BENCH_BATCH; i++) {
+            len += snprintf(batch + len, sizeof(batch) - len,
+                            "microphone,sensor=PIC32MX,source=%s,device_id=0x%02X mic_level=%.1f %lld\n",
+                            "CAN", 0x30, (float)(i % 1024), (long long)(ts + i));
+        }
+        bytes += len;
+    }
+    report("microphone snprintf", lines, now_seconds() - start, bytes);
+
+    bytes = 0;
+    start = now_seconds();
+    for (uint32_t n = 0; n < lines; n += BENCH_BATCH) {
+        lp_buffer_reset(&buf);
+        for (uint32_t i = n; i < n + BENCH_BATCH; i++) {
+            lp_line_begin(&buf, &mic_prefix);
+            lp_field_float(&buf, "mic_level", (float)(i % 1024));
+            lp_line_end(&buf, ts + i);
+        }
+        bytes += buf.len;
+    }
+    report("microphone builder", lines, now_seconds() - start, bytes);
+
+    // Every float the builder writes reads back exactly
+    char number[LP_NUMBER_MAX];
+    start = now_seconds();
+    for (uint32_t i = 0; i < lines; i++) {
+        float v = reading(i, 1.0f, 0.001f) * reading(i, 0.01f, 0.00001f);
+        number[lp_format_float(number, v)] = '\0';
+        if (strtof(number, NULL) != v) {
+            errors++;
+        }
+    }
+    elapsed = now_seconds() - start;
+    printf("round trip: %u floats checked, %u mismatches (%.3f s)\n", lines, errors, elapsed);
+
+    lp_buffer_free(&buf);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file bench_mongo_bucket.c
+ * @brief Documents per second, storage and server CPU of mongo_bucket.h
+ *
+ * Writes the same environment readings - devices reporting once a second,
+ * simulated time - to a MongoDB server in two schemas:
+ *
+ *   per reading  one insert_one per reading with a strftime timestamp, the
+ *                way save_sensor_data_to_mongodb() wrote before
+ *   bucketed     mongo_bucket.h, one document per device and minute,
+ *                flushed every 10 s of simulated time like the gateway
+ *
+ * and reports for each: writes and readings per second, documents, data,
+ * storage and index size from collStats after an fsync, and the server's
+ * CPU time (serverStatus extra_info) per 1000 readings.
+ *
+ * Build: gcc -O2 -o bench_mongo_bucket bench_mongo_bucket.c
+ *        -I/usr/include/libbson-1.0 -I/usr/include/libmongoc-1.0 -lmongoc-1.0 -lbson-1.0
+ * Usage: ./bench_mongo_bucket [uri] [readings] [devices]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mongo_bucket.h"
+
+#define BENCH_DB "bench_mongo_bucket"
+#define BENCH_BUCKET_MS 60000
+#define BENCH_FLUSH_MS 10000
+
+static const char *const fields[] = { "temperature", "humidity" };
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int64_t find_int64(const bson_t *doc, const char *path) {
+    bson_iter_t iter, found;
+    if (bson_iter_init(&iter, doc) && bson_iter_find_descendant(&iter, path, &found)) {
+        return bson_iter_as_int64(&found);
+    }
+    return 0;
+}
+
+// User and system CPU time of the server so far
+static int64_t server_cpu_us(mongoc_client_t *client) {
+    bson_t cmd, reply;
+    int64_t us = 0;
+
+    bson_init(&cmd);
+    BSON_APPEND_INT32(&cmd, "serverStatus", 1);
+    if (mongoc_client_command_simple(client, "admin", &cmd, NULL, &reply, NULL)) {
+        us = find_int64(&reply, "extra_info.user_time_us") + find_int64(&reply, "extra_info.system_time_us");
+    }
+    bson_destroy(&reply);
+    bson_destroy(&cmd);
+    return us;
+}
+
+static void report(mongoc_client_t *client, mongoc_database_t *db, const char *name, const char *collection,
+                   uint64_t writes, uint32_t readings, double elapsed, int64_t cpu_us) {
+    bson_t cmd, reply;
+
+    // Checkpoint first, storageSize lags behind otherwise
+    bson_init(&cmd);
+    BSON_APPEND_INT32(&cmd, "fsync", 1);
+    mongoc_client_command_simple(client, "admin", &cmd, NULL, &reply, NULL);
+    bson_destroy(&reply);
+    bson_destroy(&cmd);
+
+    bson_init(&cmd);
+    BSON_APPEND_UTF8(&cmd, "collStats", collection);
+    mongoc_database_command_simple(db, &cmd, NULL, &reply, NULL);     // reply is initialized either way
+
+    printf("%-12s %8.0f writes/s %8.0f readings/s  %8lld docs  data %6.2f MB  storage %6.2f MB  "
+           "index %6.2f MB  server CPU %.1f ms/1000 readings\n",
+           name, writes / elapsed, readings / elapsed, (long long)find_int64(&reply, "count"),
+           find_int64(&reply, "size") / 1e6, find_int64(&reply, "storageSize") / 1e6,
+           find_int64(&reply, "totalIndexSize") / 1e6, cpu_us / 1000.0 / (readings / 1000.0));
+
+    bson_destroy(&reply);
+    bson_destroy(&cmd);
+}
+
+static double temperature(uint32_t n, uint32_t device) {
+    return 20.0 + device * 0.5 + (double)((n * 2654435761u + device) % 200) / 100.0;
+}
+
+static double humidity(uint32_t n, uint32_t device) {
+    return 40.0 + (double)((n * 40503u + device) % 300) / 10.0;
+}
+
+int main(int argc, char **argv) {
+    const char *uri = argc > 1 ? argv[1] : "mongodb://localhost:27017";
+    uint32_t readings = argc > 2 ? (uint32_t)atoi(argv[2]) : 200000;
+    uint32_t devices = argc > 3 ? (uint32_t)atoi(argv[3]) : 8;
+    uint32_t seconds = readings / devices;
+    int64_t base_ms = 1700000000000LL;
+    bson_error_t error;
+    double start, elapsed;
+    int64_t cpu;
+
+    mongoc_init();
+    mongoc_client_t *client = mongoc_client_new(uri);
+    if (!client) {
+        fprintf(stderr, "Invalid URI %s\n", uri);
+        return EXIT_FAILURE;
+    }
+    mongoc_database_t *db = mongoc_client_get_database(client, BENCH_DB);
+    mongoc_collection_t *flat = mongoc_database_get_collection(db, "sensor_readings");
+    mongoc_collection_t *buckets = mongoc_database_get_collection(db, "sensor_buckets");
+    mongoc_collection_drop(flat, NULL);
+    mongoc_collection_drop(buckets, NULL);
+    readings = seconds * devices;
+
+    printf("%u readings, %u devices, %u s of simulated time\n", readings, devices, seconds);
+
+    // One document per reading
+    bson_t doc;
+    bson_init(&doc);
+    cpu = server_cpu_us(client);
+    start = now_seconds();
+    for (uint32_t n = 0; n < seconds; n++) {
+        for (uint32_t d = 0; d < devices; d++) {
+            time_t t = (time_t)((base_ms + n * 1000LL) / 1000);
+            char timestamp[30], id_str[10];
+            snprintf(id_str, sizeof(id_str), "%02X", d);
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&t));
+
+            bson_reinit(&doc);
+            BSON_APPEND_UTF8(&doc, "device_id", id_str);
+            BSON_APPEND_UTF8(&doc, "id_type", "legacy");
+            BSON_APPEND_UTF8(&doc, "sensor_type", "Environment");
+            BSON_APPEND_UTF8(&doc, "timestamp", timestamp);
+            BSON_APPEND_DOUBLE(&doc, "temperature", temperature(n, d));
+            BSON_APPEND_DOUBLE(&doc, "humidity", humidity(n, d));
+            if (!mongoc_collection_insert_one(flat, &doc, NULL, NULL, &error)) {
+                fprintf(stderr, "insert_one: %s\n", error.message);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    elapsed = now_seconds() - start;
+    cpu = server_cpu_us(client) - cpu;
+    bson_destroy(&doc);
+    report(client, db, "per reading", "sensor_readings", readings, readings, elapsed, cpu);
+
+    // Bucketed
+    static mongo_bucket_writer_t writer;
+    mongo_bucket_init(&writer, buckets, BENCH_BUCKET_MS);
+    cpu = server_cpu_us(client);
+    start = now_seconds();
+    for (uint32_t n = 0; n < seconds; n++) {
+        int64_t now_ms = base_ms + n * 1000LL;
+        for (uint32_t d = 0; d < devices; d++) {
+            double values[2] = { temperature(n, d), humidity(n, d) };
+            if (!mongo_bucket_add(&writer, "legacy", (uint8_t)d, "Environment", fields, 2, now_ms, values)) {
+                fprintf(stderr, "mongo_bucket_add: %s\n", writer.error.message);
+                return EXIT_FAILURE;
+            }
+        }
+        if ((now_ms - base_ms) % BENCH_FLUSH_MS == 0 && !mongo_bucket_flush(&writer)) {
+            fprintf(stderr, "mongo_bucket_flush: %s\n", writer.error.message);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!mongo_bucket_flush(&writer)) {
+        fprintf(stderr, "mongo_bucket_flush: %s\n", writer.error.message);
+        return EXIT_FAILURE;
+    }
+    elapsed = now_seconds() - start;
+    cpu = server_cpu_us(client) - cpu;
+    report(client, db, "bucketed", "sensor_buckets", writer.upserts, readings, elapsed, cpu);
+    printf("%-12s %llu upserts in %llu bulks, %.1f readings per upsert\n", "", (unsigned long long)writer.upserts,
+           (unsigned long long)writer.flushes, (double)writer.readings / writer.upserts);
+    mongo_bucket_free(&writer);
+
+    mongoc_collection_drop(flat, NULL);
+    mongoc_collection_drop(buckets, NULL);
+    mongoc_collection_destroy(flat);
+    mongoc_collection_destroy(buckets);
+    mongoc_database_destroy(db);
+    mongoc_client_destroy(client);
+    mongoc_cleanup();
+    return EXIT_SUCCESS;
+}
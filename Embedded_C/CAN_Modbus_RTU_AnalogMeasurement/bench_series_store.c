@@ -0,0 +1,143 @@
+/**
+ * @file bench_series_store.c
+ * @brief Insert and query benchmark of series_store.h
+ *
+ * Writes sensor like series (slow drift plus noise at the resolution of the
+ * Modbus registers, timestamps with jitter) into a store file, checks that
+ * every point reads back exactly, reopens the file and measures:
+ *
+ *   inserts      points per second through series_store_append()
+ *   range        points per second decoded by series_store_range()
+ *   downsample   one hour in 1 minute buckets, queries per second
+ *
+ * Build: gcc -O2 -o bench_series_store bench_series_store.c -lm
+ * Usage: ./bench_series_store [path] [points] [series]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "series_store.h"
+
+#define BENCH_BLOCKS 16384                  // 64 MiB file
+#define BENCH_INTERVAL_MS 100
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Reading n of series s, rounded to the 0.001 steps of the Modbus registers
+static double reading(uint32_t s, uint32_t n) {
+    double drift = 20.0 + s + 2.0 * sin(n / 3000.0 + s);
+    double noise = (double)((n * 2654435761u + s * 40503u) % 21) - 10.0;
+    return round((drift + noise * 0.002) * 1000.0) / 1000.0;
+}
+
+static int64_t timestamp(uint32_t n) {
+    return 1700000000000LL + (int64_t)n * BENCH_INTERVAL_MS + (n * 7919u) % 5;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "bench_series_store.db";
+    uint32_t points = argc > 2 ? (uint32_t)atoi(argv[2]) : 2000000;
+    uint32_t series = argc > 3 ? (uint32_t)atoi(argv[3]) : 16;
+    uint32_t per_series = points / series;
+    static series_store_t store;
+    double start, elapsed;
+
+    unlink(path);
+    if (!series_store_open(&store, path, BENCH_BLOCKS)) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    // Inserts, series interleaved like the readings of the gateway
+    start = now_seconds();
+    for (uint32_t n = 0; n < per_series; n++) {
+        for (uint32_t s = 0; s < series; s++) {
+            series_store_append(&store, s, timestamp(n), reading(s, n));
+        }
+    }
+    elapsed = now_seconds() - start;
+
+    uint64_t held = 0, bytes = 0;
+    for (uint32_t s = 0; s < series; s++) {
+        const series_store_series_t *info = series_store_find(&store, s, false);
+        int64_t oldest;
+        uint64_t used;
+        if (info && series_store_info(&store, s, &oldest, &used)) {
+            held += info->points;
+            bytes += used;
+        }
+    }
+    printf("insert:     %u points in %.3f s, %.0f points/s\n", per_series * series, elapsed,
+           per_series * series / elapsed);
+    printf("storage:    %llu points held, %.2f bytes/point (16 raw)\n", (unsigned long long)held,
+           held ? (double)bytes / held : 0.0);
+
+    series_store_close(&store);
+
+    // Recovery
+    start = now_seconds();
+    if (!series_store_open(&store, path, BENCH_BLOCKS)) {
+        fprintf(stderr, "Cannot reopen %s\n", path);
+        return EXIT_FAILURE;
+    }
+    printf("reopen:     %.3f s\n", now_seconds() - start);
+
+    // Every point held reads back exactly, appending continues after reopen
+    uint32_t capacity = per_series + 16;
+    series_store_point_t *out = malloc(capacity * sizeof(series_store_point_t));
+    uint32_t errors = 0;
+
+    for (uint32_t s = 0; s < series; s++) {
+        series_store_append(&store, s, timestamp(per_series), reading(s, per_series));
+    }
+    for (uint32_t s = 0; s < series; s++) {
+        uint32_t count = series_store_range(&store, s, 0, INT64_MAX, out, capacity);
+        uint32_t first = per_series + 1 - count;
+        for (uint32_t i = 0; i < count; i++) {
+            if (out[i].timestamp_ms != timestamp(first + i) || out[i].value != reading(s, first + i)) {
+                errors++;
+            }
+        }
+    }
+    printf("verify:     %u mismatches\n", errors);
+
+    // Range queries over the last tenth of every series
+    uint64_t decoded = 0;
+    start = now_seconds();
+    for (int round = 0; round < 10; round++) {
+        for (uint32_t s = 0; s < series; s++) {
+            decoded += series_store_range(&store, s, timestamp(per_series - per_series / 10), timestamp(per_series),
+                                          out, capacity);
+        }
+    }
+    elapsed = now_seconds() - start;
+    printf("range:      %llu points in %.3f s, %.0f points/s\n", (unsigned long long)decoded, elapsed,
+           decoded / elapsed);
+
+    // Dashboard history: the last hour in 1 minute buckets
+    series_store_bucket_t buckets[64];
+    uint32_t queries = 0, bucket_count = 0;
+    int64_t to = timestamp(per_series);
+    start = now_seconds();
+    do {
+        for (uint32_t s = 0; s < series; s++) {
+            bucket_count += series_store_downsample(&store, s, to - 3600000, to, 60000, buckets, 64);
+            queries++;
+        }
+        elapsed = now_seconds() - start;
+    } while (elapsed < 1.0);
+    printf("downsample: %u queries (1 h in 1 min buckets, %u buckets each) in %.3f s, %.0f queries/s\n",
+           queries, bucket_count / queries, elapsed, queries / elapsed);
+
+    free(out);
+    series_store_close(&store);
+    unlink(path);
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
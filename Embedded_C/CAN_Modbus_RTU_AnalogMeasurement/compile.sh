@@ -1,7 +1,7 @@
 #!/bin/bash
 
 # Compile Main.c with required libraries and includes
-gcc -o Main Main.c -I/usr/include/libbson-1.0 -I/usr/include/libmongoc-1.0 -lpigpio -lpthread -lcurl -lmongoc-1.0 -lbson-1.0 -Wall
+gcc -o Main Main.c -I/usr/include/libbson-1.0 -I/usr/include/libmongoc-1.0 -lpigpio -lpthread -lcurl -lmongoc-1.0 -lbson-1.0 -lz -lm -Wall
 
 # Check if compilation was successful
 if [ $? -eq 0 ]; then
@@ -10,3 +10,15 @@ else
     echo "Compilation failed!"
     exit 1
 fi
+
+# Insert/query benchmark of the local time series store
+gcc -O2 -o bench_series_store bench_series_store.c -lm -Wall || exit 1
+
+# Line protocol builder against the snprintf lines
+gcc -O2 -o bench_line_protocol bench_line_protocol.c -lm -Wall || exit 1
+
+# Compressed concurrent InfluxDB writes against a local stand-in
+gcc -O2 -o bench_http_sink bench_http_sink.c -lcurl -lz -lpthread -lm -Wall || exit 1
+
+# Bucketed against per reading MongoDB documents, needs a MongoDB server to run
+gcc -O2 -o bench_mongo_bucket bench_mongo_bucket.c -I/usr/include/libbson-1.0 -I/usr/include/libmongoc-1.0 -lmongoc-1.0 -lbson-1.0 -Wall || exit 1
@@ -0,0 +1,465 @@
+/**
+ * @file http_sink.h
+ * @brief Compressed batch writes over HTTP with concurrent requests
+ * @version 1.0
+ * @date 2026
+ *
+ * Batches handed to http_sink_send() are compressed once and queued. Up to
+ * config.inflight of them are POSTed at the same time through curl multi,
+ * one easy handle per request slot, set up once and kept with its
+ * connection, so consecutive writes reuse the keep-alive connection instead
+ * of connecting again. Nothing blocks: http_sink_poll() moves the transfers
+ * on and collects the answers.
+ *
+ *   HTTP_SINK_IDENTITY   body as given
+ *   HTTP_SINK_GZIP       Content-Encoding: gzip, accepted by InfluxDB
+ *   HTTP_SINK_ZSTD       Content-Encoding: zstd, for targets that accept it,
+ *                        needs HTTP_SINK_ZSTD_ENABLE and -lzstd
+ *
+ * A 2xx answer acknowledges a batch. Transport errors, 408, 429 and 5xx
+ * are retried after retry_ms, doubled with every attempt, up to
+ * max_attempts; any other answer (bad line protocol, 401, 413) would fail
+ * again and gives up at once. The callback hears about every batch that is
+ * acknowledged or lost. When the queue is full the oldest batch that is not
+ * in flight is dropped to make room, newer data being worth more.
+ *
+ * Bytes on the wire count requests, bodies included, and response headers
+ * of every attempt, retries included.
+ */
+
+#ifndef HTTP_SINK_H
+#define HTTP_SINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <curl/curl.h>
+#include <zlib.h>
+#ifdef HTTP_SINK_ZSTD_ENABLE
+#include <zstd.h>
+#endif
+
+#ifndef HTTP_SINK_MAX_INFLIGHT
+#define HTTP_SINK_MAX_INFLIGHT  8           // request slots
+#endif
+#ifndef HTTP_SINK_QUEUE
+#define HTTP_SINK_QUEUE         32          // batches waiting or in flight
+#endif
+
+typedef enum {
+    HTTP_SINK_IDENTITY,
+    HTTP_SINK_GZIP,
+    HTTP_SINK_ZSTD
+} http_sink_encoding_t;
+
+/**
+ * @brief Outcome of a batch
+ * @param status HTTP status of the last attempt, 0 without an answer
+ */
+typedef void (*http_sink_result_fn)(void *context, uint32_t lines, long status, bool acked);
+
+typedef struct {
+    const char *url;
+    const struct curl_slist *headers;       // copied, Content-Encoding is added
+    int inflight;                           // concurrent requests, 1 to HTTP_SINK_MAX_INFLIGHT
+    http_sink_encoding_t encoding;
+    int level;                              // compression level, 0 for the library default
+    int max_attempts;
+    int64_t retry_ms;                       // delay before the first retry
+    long timeout_ms;                        // per request
+    http_sink_result_fn on_result;          // may be NULL
+    void *context;
+} http_sink_config_t;
+
+typedef enum {
+    HTTP_SINK_FREE,
+    HTTP_SINK_WAITING,
+    HTTP_SINK_SENDING
+} http_sink_state_t;
+
+typedef struct {
+    http_sink_state_t state;
+    uint64_t seq;                           // send order
+    uint8_t *body;                          // encoded, kept for retries
+    size_t len;
+    size_t cap;
+    uint32_t lines;
+    int attempts;
+    int64_t not_before_ms;
+} http_sink_batch_t;
+
+typedef struct {
+    uint64_t batches;                       // handed to http_sink_send()
+    uint64_t acked;
+    uint64_t retries;
+    uint64_t failed;                        // given up after an answer or max_attempts
+    uint64_t dropped;                       // pushed out of a full queue
+    uint64_t lines_acked;
+    uint64_t lines_lost;
+    uint64_t raw_bytes;                     // before compression
+    uint64_t body_bytes;                    // after compression
+    uint64_t wire_bytes;                    // requests and answer headers of all attempts
+} http_sink_stats_t;
+
+typedef struct {
+    http_sink_config_t config;
+    CURLM *multi;
+    CURL *easy[HTTP_SINK_MAX_INFLIGHT];
+    int slot_batch[HTTP_SINK_MAX_INFLIGHT]; // batch of the request slot, -1 when idle
+    struct curl_slist *headers;
+    http_sink_batch_t batches[HTTP_SINK_QUEUE];
+    uint64_t next_seq;
+    int sending;
+    z_stream gzip;
+    bool gzip_ready;
+#ifdef HTTP_SINK_ZSTD_ENABLE
+    ZSTD_CCtx *zstd;
+#endif
+    http_sink_stats_t stats;
+} http_sink_t;
+
+static inline int64_t http_sink_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Answer bodies are of no interest, InfluxDB only explains errors in them
+static inline size_t http_sink_discard(char *data, size_t size, size_t count, void *context) {
+    (void)data;
+    (void)context;
+    return size * count;
+}
+
+static inline void http_sink_cleanup(http_sink_t *sink);
+
+/**
+ * @brief Set up the request slots and the compressor
+ * @return false if curl or the compressor could not be set up
+ */
+static inline bool http_sink_init(http_sink_t *sink, const http_sink_config_t *config) {
+    memset(sink, 0, sizeof(*sink));
+    sink->config = *config;
+    if (sink->config.inflight < 1) sink->config.inflight = 1;
+    if (sink->config.inflight > HTTP_SINK_MAX_INFLIGHT) sink->config.inflight = HTTP_SINK_MAX_INFLIGHT;
+    if (sink->config.max_attempts < 1) sink->config.max_attempts = 1;
+    for (int i = 0; i < HTTP_SINK_MAX_INFLIGHT; i++) {
+        sink->slot_batch[i] = -1;
+    }
+
+    // Headers of the caller, the encoding, and no Expect: 100-continue,
+    // which would cost a round trip before every larger body
+    for (const struct curl_slist *h = config->headers; h; h = h->next) {
+        sink->headers = curl_slist_append(sink->headers, h->data);
+    }
+    if (config->encoding == HTTP_SINK_GZIP) {
+        sink->headers = curl_slist_append(sink->headers, "Content-Encoding: gzip");
+    } else if (config->encoding == HTTP_SINK_ZSTD) {
+        sink->headers = curl_slist_append(sink->headers, "Content-Encoding: zstd");
+    }
+    sink->headers = curl_slist_append(sink->headers, "Expect:");
+
+    if (config->encoding == HTTP_SINK_GZIP) {
+        // windowBits 15 + 16 for the gzip wrapper instead of zlib
+        if (deflateInit2(&sink->gzip, config->level ? config->level : Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            http_sink_cleanup(sink);
+            return false;
+        }
+        sink->gzip_ready = true;
+    } else if (config->encoding == HTTP_SINK_ZSTD) {
+#ifdef HTTP_SINK_ZSTD_ENABLE
+        sink->zstd = ZSTD_createCCtx();
+        if (!sink->zstd) {
+            http_sink_cleanup(sink);
+            return false;
+        }
+#else
+        http_sink_cleanup(sink);
+        return false;
+#endif
+    }
+
+    sink->multi = curl_multi_init();
+    if (!sink->multi) {
+        http_sink_cleanup(sink);
+        return false;
+    }
+    curl_multi_setopt(sink->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)sink->config.inflight);
+    curl_multi_setopt(sink->multi, CURLMOPT_MAXCONNECTS, (long)sink->config.inflight);
+
+    for (int i = 0; i < sink->config.inflight; i++) {
+        CURL *easy = curl_easy_init();
+        if (!easy) {
+            http_sink_cleanup(sink);
+            return false;
+        }
+        curl_easy_setopt(easy, CURLOPT_URL, config->url);
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, sink->headers);
+        curl_easy_setopt(easy, CURLOPT_POST, 1L);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, http_sink_discard);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, config->timeout_ms);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        sink->easy[i] = easy;
+    }
+
+    return true;
+}
+
+// Encode data into the body of a batch
+static inline bool http_sink_encode(http_sink_t *sink, http_sink_batch_t *batch, const char *data, size_t len) {
+    size_t bound = len;
+
+    if (sink->config.encoding == HTTP_SINK_GZIP) {
+        bound = deflateBound(&sink->gzip, len);
+    }
+#ifdef HTTP_SINK_ZSTD_ENABLE
+    if (sink->config.encoding == HTTP_SINK_ZSTD) {
+        bound = ZSTD_compressBound(len);
+    }
+#endif
+
+    if (bound > batch->cap) {
+        uint8_t *body = realloc(batch->body, bound);
+        if (!body) {
+            return false;
+        }
+        batch->body = body;
+        batch->cap = bound;
+    }
+
+    if (sink->config.encoding == HTTP_SINK_GZIP) {
+        deflateReset(&sink->gzip);
+        sink->gzip.next_in = (Bytef *)data;
+        sink->gzip.avail_in = (uInt)len;
+        sink->gzip.next_out = batch->body;
+        sink->gzip.avail_out = (uInt)batch->cap;
+        if (deflate(&sink->gzip, Z_FINISH) != Z_STREAM_END) {
+            return false;
+        }
+        batch->len = sink->gzip.total_out;
+        return true;
+    }
+#ifdef HTTP_SINK_ZSTD_ENABLE
+    if (sink->config.encoding == HTTP_SINK_ZSTD) {
+        size_t out = ZSTD_compressCCtx(sink->zstd, batch->body, batch->cap, data, len,
+                                       sink->config.level ? sink->config.level : ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(out)) {
+            return false;
+        }
+        batch->len = out;
+        return true;
+    }
+#endif
+
+    memcpy(batch->body, data, len);
+    batch->len = len;
+    return true;
+}
+
+static inline void http_sink_finish(http_sink_t *sink, http_sink_batch_t *batch, long status, bool acked) {
+    if (acked) {
+        sink->stats.acked++;
+        sink->stats.lines_acked += batch->lines;
+    } else {
+        sink->stats.lines_lost += batch->lines;
+    }
+    batch->state = HTTP_SINK_FREE;
+    if (sink->config.on_result) {
+        sink->config.on_result(sink->config.context, batch->lines, status, acked);
+    }
+}
+
+// Put waiting batches, oldest first, on idle request slots
+static inline void http_sink_start(http_sink_t *sink, int64_t now_ms) {
+    for (int slot = 0; slot < sink->config.inflight; slot++) {
+        if (sink->slot_batch[slot] >= 0) {
+            continue;
+        }
+
+        int next = -1;
+        for (int i = 0; i < HTTP_SINK_QUEUE; i++) {
+            http_sink_batch_t *batch = &sink->batches[i];
+            if (batch->state == HTTP_SINK_WAITING && batch->not_before_ms <= now_ms &&
+                (next < 0 || batch->seq < sink->batches[next].seq)) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            return;
+        }
+
+        http_sink_batch_t *batch = &sink->batches[next];
+        curl_easy_setopt(sink->easy[slot], CURLOPT_POSTFIELDS, (const char *)batch->body);
+        curl_easy_setopt(sink->easy[slot], CURLOPT_POSTFIELDSIZE, (long)batch->len);
+        if (curl_multi_add_handle(sink->multi, sink->easy[slot]) != CURLM_OK) {
+            return;
+        }
+        batch->state = HTTP_SINK_SENDING;
+        batch->attempts++;
+        sink->slot_batch[slot] = next;
+        sink->sending++;
+    }
+}
+
+/**
+ * @brief Queue a batch, the data is compressed and copied
+ * @return false if it could not be queued, the callback is not called then
+ */
+static inline bool http_sink_send(http_sink_t *sink, const char *data, size_t len, uint32_t lines) {
+    http_sink_batch_t *batch = NULL;
+    http_sink_batch_t *oldest = NULL;
+
+    for (int i = 0; i < HTTP_SINK_QUEUE && !batch; i++) {
+        http_sink_batch_t *b = &sink->batches[i];
+        if (b->state == HTTP_SINK_FREE) {
+            batch = b;
+        } else if (b->state == HTTP_SINK_WAITING && (!oldest || b->seq < oldest->seq)) {
+            oldest = b;
+        }
+    }
+
+    if (!batch) {
+        if (!oldest) {
+            return false;
+        }
+        sink->stats.dropped++;
+        http_sink_finish(sink, oldest, 0, false);
+        batch = oldest;
+    }
+
+    if (!http_sink_encode(sink, batch, data, len)) {
+        return false;
+    }
+
+    batch->state = HTTP_SINK_WAITING;
+    batch->seq = sink->next_seq++;
+    batch->lines = lines;
+    batch->attempts = 0;
+    batch->not_before_ms = 0;
+    sink->stats.batches++;
+    sink->stats.raw_bytes += len;
+    sink->stats.body_bytes += batch->len;
+
+    http_sink_start(sink, http_sink_now_ms());
+    return true;
+}
+
+/**
+ * @brief Move the transfers on, collect answers and start waiting batches
+ * @return batches waiting or in flight
+ */
+static inline int http_sink_poll(http_sink_t *sink) {
+    int running;
+    int left;
+    CURLMsg *msg;
+    int64_t now_ms = http_sink_now_ms();
+
+    curl_multi_perform(sink->multi, &running);
+
+    while ((msg = curl_multi_info_read(sink->multi, &left))) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        int slot = 0;
+        while (slot < sink->config.inflight && sink->easy[slot] != msg->easy_handle) {
+            slot++;
+        }
+        if (slot == sink->config.inflight || sink->slot_batch[slot] < 0) {
+            continue;
+        }
+
+        http_sink_batch_t *batch = &sink->batches[sink->slot_batch[slot]];
+        CURLcode result = msg->data.result;
+        long status = 0, request_size = 0, header_size = 0;
+
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &status);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_REQUEST_SIZE, &request_size);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_HEADER_SIZE, &header_size);
+        curl_multi_remove_handle(sink->multi, msg->easy_handle);
+        sink->slot_batch[slot] = -1;
+        sink->sending--;
+        sink->stats.wire_bytes += (uint64_t)request_size + (uint64_t)header_size;
+
+        if (result == CURLE_OK && status >= 200 && status < 300) {
+            http_sink_finish(sink, batch, status, true);
+            continue;
+        }
+
+        bool transient = result != CURLE_OK || status == 408 || status == 429 || status >= 500;
+        if (transient && batch->attempts < sink->config.max_attempts) {
+            batch->state = HTTP_SINK_WAITING;
+            batch->not_before_ms = now_ms + (sink->config.retry_ms << (batch->attempts - 1));
+            sink->stats.retries++;
+        } else {
+            sink->stats.failed++;
+            http_sink_finish(sink, batch, status, false);
+        }
+    }
+
+    http_sink_start(sink, now_ms);
+
+    int pending = 0;
+    for (int i = 0; i < HTTP_SINK_QUEUE; i++) {
+        if (sink->batches[i].state != HTTP_SINK_FREE) {
+            pending++;
+        }
+    }
+    return pending;
+}
+
+/**
+ * @brief Poll until every batch is answered or timeout_ms has passed
+ * @return batches still waiting or in flight
+ */
+static inline int http_sink_drain(http_sink_t *sink, int64_t timeout_ms) {
+    int64_t deadline = http_sink_now_ms() + timeout_ms;
+    int pending;
+
+    while ((pending = http_sink_poll(sink)) > 0 && http_sink_now_ms() < deadline) {
+        curl_multi_poll(sink->multi, NULL, 0, 10, NULL);
+    }
+    return pending;
+}
+
+static inline void http_sink_cleanup(http_sink_t *sink) {
+    for (int i = 0; i < HTTP_SINK_MAX_INFLIGHT; i++) {
+        if (sink->easy[i]) {
+            if (sink->slot_batch[i] >= 0) {
+                curl_multi_remove_handle(sink->multi, sink->easy[i]);
+            }
+            curl_easy_cleanup(sink->easy[i]);
+            sink->easy[i] = NULL;
+        }
+    }
+    if (sink->multi) {
+        curl_multi_cleanup(sink->multi);
+        sink->multi = NULL;
+    }
+    if (sink->headers) {
+        curl_slist_free_all(sink->headers);
+        sink->headers = NULL;
+    }
+    if (sink->gzip_ready) {
+        deflateEnd(&sink->gzip);
+        sink->gzip_ready = false;
+    }
+#ifdef HTTP_SINK_ZSTD_ENABLE
+    if (sink->zstd) {
+        ZSTD_freeCCtx(sink->zstd);
+        sink->zstd = NULL;
+    }
+#endif
+    for (int i = 0; i < HTTP_SINK_QUEUE; i++) {
+        free(sink->batches[i].body);
+        sink->batches[i].body = NULL;
+        sink->batches[i].cap = 0;
+        sink->batches[i].state = HTTP_SINK_FREE;
+    }
+}
+
+#endif // HTTP_SINK_H
@@ -0,0 +1,418 @@
+/**
+ * @file line_protocol.h
+ * @brief InfluxDB line protocol builder without per line allocations
+ * @version 1.0
+ * @date 2026
+ *
+ * Lines are appended to a growable batch buffer that is reset, not freed,
+ * between writes, so it stops allocating once it has grown to the largest
+ * batch. The measurement and tag set of a series is escaped once into an
+ * lp_prefix_t and copied in front of every line.
+ *
+ *   lp_line_begin(&batch, &prefix);
+ *   lp_field_float(&batch, "temperature", 21.5f);
+ *   lp_field_int(&batch, "count", 42);
+ *   lp_line_end(&batch, timestamp_ns);
+ *
+ * Numbers are written as the shortest decimal that reads back as the same
+ * value: floats as float, doubles as double. Values with up to
+ * LP_MAX_DECIMALS decimals, below 2^52 once scaled (2^24 for floats) - all
+ * sensor readings - are found by an exact test against the powers of ten,
+ * anything else by trying %.Ng precisions. NaN and infinity have no line
+ * protocol form, such fields are left out and a line without any field is
+ * dropped by lp_line_end().
+ */
+
+#ifndef LINE_PROTOCOL_H
+#define LINE_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#define LP_PREFIX_MAX       192
+#define LP_NUMBER_MAX       32              // longest formatted number
+#define LP_MAX_DECIMALS     15
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    size_t lines;
+    size_t line_start;                      // offset of the line being built
+    size_t line_fields;                     // fields of the line being built
+    bool failed;                            // out of memory, the batch is incomplete
+} lp_buffer_t;
+
+typedef struct {
+    char text[LP_PREFIX_MAX];
+    uint16_t len;
+    bool truncated;
+} lp_prefix_t;
+
+/* ========================================================================== */
+/*                                  BUFFER                                   */
+/* ========================================================================== */
+
+static inline bool lp_buffer_init(lp_buffer_t *buf, size_t capacity) {
+    memset(buf, 0, sizeof(*buf));
+    buf->data = malloc(capacity ? capacity : 1);
+    buf->cap = buf->data ? (capacity ? capacity : 1) : 0;
+    if (buf->data) {
+        buf->data[0] = '\0';
+    }
+    return buf->data != NULL;
+}
+
+static inline void lp_buffer_free(lp_buffer_t *buf) {
+    free(buf->data);
+    memset(buf, 0, sizeof(*buf));
+}
+
+// Empty the batch, keeping its memory
+static inline void lp_buffer_reset(lp_buffer_t *buf) {
+    buf->len = 0;
+    buf->lines = 0;
+    buf->line_start = 0;
+    buf->line_fields = 0;
+    buf->failed = false;
+    if (buf->data) {
+        buf->data[0] = '\0';
+    }
+}
+
+// Room for extra more bytes and the terminating NUL
+static inline bool lp_buffer_reserve(lp_buffer_t *buf, size_t extra) {
+    if (buf->len + extra + 1 <= buf->cap) {
+        return true;
+    }
+
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < buf->len + extra + 1) {
+        cap *= 2;
+    }
+
+    char *data = realloc(buf->data, cap);
+    if (!data) {
+        buf->failed = true;
+        return false;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return true;
+}
+
+static inline void lp_put(lp_buffer_t *buf, const char *text, size_t len) {
+    memcpy(buf->data + buf->len, text, len);
+    buf->len += len;
+}
+
+/* ========================================================================== */
+/*                                 ESCAPING                                  */
+/* ========================================================================== */
+
+// Copy text escaping the characters in special, returns the length or
+// SIZE_MAX if it does not fit into max bytes
+static inline size_t lp_escape(char *out, size_t max, const char *text, const char *special) {
+    size_t len = 0;
+
+    for (; *text; text++) {
+        if (strchr(special, *text)) {
+            if (len + 2 > max) {
+                return SIZE_MAX;
+            }
+            out[len++] = '\\';
+        } else if (len + 1 > max) {
+            return SIZE_MAX;
+        }
+        out[len++] = *text;
+    }
+    return len;
+}
+
+static inline size_t lp_escaped_length(const char *text, const char *special) {
+    size_t len = 0;
+    for (; *text; text++) {
+        len += strchr(special, *text) ? 2 : 1;
+    }
+    return len;
+}
+
+/* ========================================================================== */
+/*                                  PREFIX                                   */
+/* ========================================================================== */
+
+static inline void lp_prefix_init(lp_prefix_t *prefix, const char *measurement) {
+    size_t len = lp_escape(prefix->text, LP_PREFIX_MAX, measurement, ", ");
+
+    prefix->truncated = len == SIZE_MAX;
+    prefix->len = prefix->truncated ? 0 : (uint16_t)len;
+}
+
+/**
+ * @brief Add a tag, tags should be added in key order for InfluxDB
+ * @return false if the prefix is full
+ */
+static inline bool lp_prefix_tag(lp_prefix_t *prefix, const char *key, const char *value) {
+    char *out = prefix->text + prefix->len;
+    size_t room = LP_PREFIX_MAX - prefix->len;
+    size_t key_len, value_len;
+
+    if (room < 2 || (key_len = lp_escape(out + 1, room - 2, key, ",= ")) == SIZE_MAX ||
+        (value_len = lp_escape(out + 2 + key_len, room - 2 - key_len, value, ",= ")) == SIZE_MAX) {
+        prefix->truncated = true;
+        return false;
+    }
+
+    out[0] = ',';
+    out[1 + key_len] = '=';
+    prefix->len += (uint16_t)(2 + key_len + value_len);
+    return true;
+}
+
+/* ========================================================================== */
+/*                                 NUMBERS                                   */
+/* ========================================================================== */
+
+static const char lp_digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const double lp_pow10[LP_MAX_DECIMALS + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// Decimal digits of value, right aligned to end, returns the first digit
+static inline char *lp_format_digits(char *end, uint64_t value) {
+    while (value >= 100) {
+        const char *pair = &lp_digit_pairs[(value % 100) * 2];
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (value >= 10) {
+        const char *pair = &lp_digit_pairs[value * 2];
+        *--end = pair[1];
+        *--end = pair[0];
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+static inline size_t lp_format_int(char *out, int64_t value) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char *start = lp_format_digits(end, magnitude);
+    size_t len = 0;
+
+    if (value < 0) {
+        out[len++] = '-';
+    }
+    memcpy(out + len, start, end - start);
+    return len + (end - start);
+}
+
+// n / 10^decimals as a decimal number
+static inline size_t lp_format_scaled(char *out, bool negative, uint64_t n, int decimals) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *start = lp_format_digits(end, n);
+    size_t count = end - start;
+    size_t len = 0;
+
+    if (negative && n) {
+        out[len++] = '-';
+    }
+
+    if (decimals == 0) {
+        memcpy(out + len, start, count);
+        return len + count;
+    }
+
+    if (count <= (size_t)decimals) {
+        out[len++] = '0';
+        out[len++] = '.';
+        memset(out + len, '0', decimals - count);
+        len += decimals - count;
+        memcpy(out + len, start, count);
+        return len + count;
+    }
+
+    memcpy(out + len, start, count - decimals);
+    len += count - decimals;
+    out[len++] = '.';
+    memcpy(out + len, end - decimals, decimals);
+    return len + decimals;
+}
+
+// Shortest %.Ng that reads back as value
+static inline size_t lp_format_fallback(char *out, double value, bool as_float) {
+    for (int precision = 1; precision <= 17; precision++) {
+        int len = snprintf(out, LP_NUMBER_MAX, "%.*g", precision, value);
+        double back = strtod(out, NULL);
+        if (as_float ? (float)back == (float)value : back == value) {
+            return (size_t)len;
+        }
+    }
+    return (size_t)snprintf(out, LP_NUMBER_MAX, "%.17g", value);
+}
+
+/**
+ * @brief Shortest decimal that reads back as value
+ * @return length, 0 for NaN and infinity
+ */
+static inline size_t lp_format_double(char *out, double value) {
+    if (!isfinite(value)) {
+        return 0;
+    }
+
+    double magnitude = fabs(value);
+    if (magnitude < 9007199254740992.0) {
+        for (int decimals = 0; decimals <= LP_MAX_DECIMALS; decimals++) {
+            double scaled = magnitude * lp_pow10[decimals];
+            if (scaled >= 4503599627370496.0) {     // 2^52, rounding would not be exact
+                break;
+            }
+            uint64_t n = (uint64_t)(scaled + 0.5);
+            if ((double)n / lp_pow10[decimals] == magnitude) {
+                return lp_format_scaled(out, value < 0, n, decimals);
+            }
+        }
+    }
+    return lp_format_fallback(out, value, false);
+}
+
+/**
+ * @brief Shortest decimal that reads back as the float value
+ * @return length, 0 for NaN and infinity
+ */
+static inline size_t lp_format_float(char *out, float value) {
+    if (!isfinite(value)) {
+        return 0;
+    }
+
+    // Above 2^24 floats are no longer exact integers, their digits would be noise
+    double magnitude = fabs((double)value);
+    if (magnitude < 16777216.0) {
+        for (int decimals = 0; decimals <= LP_MAX_DECIMALS; decimals++) {
+            double scaled = magnitude * lp_pow10[decimals];
+            if (scaled >= 4503599627370496.0) {
+                break;
+            }
+            uint64_t n = (uint64_t)(scaled + 0.5);
+            if ((float)((double)n / lp_pow10[decimals]) == (float)magnitude) {
+                return lp_format_scaled(out, value < 0, n, decimals);
+            }
+        }
+    }
+    return lp_format_fallback(out, value, true);
+}
+
+/* ========================================================================== */
+/*                                   LINES                                   */
+/* ========================================================================== */
+
+static inline void lp_line_begin(lp_buffer_t *buf, const lp_prefix_t *prefix) {
+    buf->line_start = buf->len;
+    buf->line_fields = 0;
+
+    if (lp_buffer_reserve(buf, prefix->len + 1)) {
+        lp_put(buf, prefix->text, prefix->len);
+        buf->data[buf->len++] = ' ';
+    }
+}
+
+// Separator and escaped key=, false if out of memory
+static inline bool lp_field_key(lp_buffer_t *buf, const char *key, size_t value_max) {
+    size_t key_len = lp_escaped_length(key, ",= ");
+
+    if (!lp_buffer_reserve(buf, key_len + value_max + 2)) {
+        return false;
+    }
+    if (buf->line_fields++) {
+        buf->data[buf->len++] = ',';
+    }
+    buf->len += lp_escape(buf->data + buf->len, key_len, key, ",= ");
+    buf->data[buf->len++] = '=';
+    return true;
+}
+
+static inline bool lp_field_double(lp_buffer_t *buf, const char *key, double value) {
+    char number[LP_NUMBER_MAX];
+    size_t len = lp_format_double(number, value);
+
+    if (len == 0 || !lp_field_key(buf, key, len)) {
+        return false;
+    }
+    lp_put(buf, number, len);
+    return true;
+}
+
+static inline bool lp_field_float(lp_buffer_t *buf, const char *key, float value) {
+    char number[LP_NUMBER_MAX];
+    size_t len = lp_format_float(number, value);
+
+    if (len == 0 || !lp_field_key(buf, key, len)) {
+        return false;
+    }
+    lp_put(buf, number, len);
+    return true;
+}
+
+static inline bool lp_field_int(lp_buffer_t *buf, const char *key, int64_t value) {
+    if (!lp_field_key(buf, key, 21)) {
+        return false;
+    }
+    buf->len += lp_format_int(buf->data + buf->len, value);
+    buf->data[buf->len++] = 'i';
+    return true;
+}
+
+static inline bool lp_field_bool(lp_buffer_t *buf, const char *key, bool value) {
+    if (!lp_field_key(buf, key, 5)) {
+        return false;
+    }
+    lp_put(buf, value ? "true" : "false", value ? 4 : 5);
+    return true;
+}
+
+static inline bool lp_field_string(lp_buffer_t *buf, const char *key, const char *value) {
+    size_t len = lp_escaped_length(value, "\"\\");
+
+    if (!lp_field_key(buf, key, len + 2)) {
+        return false;
+    }
+    buf->data[buf->len++] = '"';
+    buf->len += lp_escape(buf->data + buf->len, len, value, "\"\\");
+    buf->data[buf->len++] = '"';
+    return true;
+}
+
+/**
+ * @brief Finish the line with its timestamp, in the precision of the write URL
+ * @return false if the line was dropped (no fields, out of memory)
+ */
+static inline bool lp_line_end(lp_buffer_t *buf, int64_t timestamp) {
+    if (buf->line_fields == 0 || buf->failed || !lp_buffer_reserve(buf, 23)) {
+        buf->len = buf->line_start;
+        if (buf->data) {
+            buf->data[buf->len] = '\0';
+        }
+        return false;
+    }
+
+    buf->data[buf->len++] = ' ';
+    buf->len += lp_format_int(buf->data + buf->len, timestamp);
+    buf->data[buf->len++] = '\n';
+    buf->data[buf->len] = '\0';
+    buf->lines++;
+    return true;
+}
+
+#endif // LINE_PROTOCOL_H
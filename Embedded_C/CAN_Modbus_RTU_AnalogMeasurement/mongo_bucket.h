@@ -0,0 +1,376 @@
+/**
+ * @file mongo_bucket.h
+ * @brief Time bucketed MongoDB sensor documents
+ * @version 1.0
+ * @date 2026
+ *
+ * Readings are collected per series (id type, device, sensor type) and per
+ * time bucket of bucket_ms, one document per series and bucket:
+ *
+ *   { _id: "legacy/00/Environment/1700000040000",
+ *     id_type: "legacy", device_id: "00", sensor_type: "Environment",
+ *     start: Date, end: Date, count: 12,
+ *     readings: [ { t: Date, temperature: 21.5, humidity: 40.1 }, ... ] }
+ *
+ * mongo_bucket_flush() writes the readings of all series since the last
+ * flush as one unordered bulk of upserts that append them to the bucket,
+ * so a bucket is written a few times while it is open instead of once per
+ * reading. The _id names series and bucket start, the upserts find their
+ * document through the _id index alone and no other index is needed. A
+ * series that moves on to the next bucket, or whose pending readings are
+ * full, is flushed by mongo_bucket_add() first.
+ *
+ * Readings of a failed upsert stay pending and go out with the next flush,
+ * together with those added since. The upsert is an update pipeline that
+ * only appends readings newer than the bucket's end and derives end and
+ * count from the readings, so an upsert that went through although the
+ * flush failed, e.g. before the connection broke, is not stored twice when
+ * it is sent again. Readings of a series must be in time order: after the
+ * wall clock stepped back, readings up to the bucket's end are skipped.
+ * Update pipelines need MongoDB 4.2 or later. A bulk whose only error is a
+ * writeConcernError was applied.
+ *
+ * An upsert the server rejects, e.g. on document validation, is retried
+ * MONGO_BUCKET_RETRIES times, then its readings are given up and counted
+ * as lost. A bulk that did not get through at all is retried for as long as
+ * there is room. While the last flush failed mongo_bucket_add() leaves the
+ * retry to the next mongo_bucket_flush(), and a reading that no longer fits
+ * next to the kept ones is counted as lost as well.
+ *
+ * The bson_t documents of a flush are kept and cleared with bson_reinit(),
+ * so after the first flush their buffers are reused.
+ */
+
+#ifndef MONGO_BUCKET_H
+#define MONGO_BUCKET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <libmongoc-1.0/mongoc.h>
+#include <libbson-1.0/bson.h>
+
+#ifndef MONGO_BUCKET_SERIES
+#define MONGO_BUCKET_SERIES     32
+#endif
+#ifndef MONGO_BUCKET_PENDING
+#define MONGO_BUCKET_PENDING    64          // readings per series between flushes
+#endif
+#ifndef MONGO_BUCKET_RETRIES
+#define MONGO_BUCKET_RETRIES    3           // flushes an upsert rejected by the server is tried
+#endif
+#define MONGO_BUCKET_FIELDS     4           // values per reading
+
+typedef struct {
+    int64_t timestamp_ms;
+    double values[MONGO_BUCKET_FIELDS];
+} mongo_reading_t;
+
+typedef struct {
+    bool used;
+    char id_type[16];
+    char device_id[8];
+    char sensor_type[24];
+    const char *const *fields;              // names of the values, static
+    int field_count;
+    int64_t start_ms;                       // of the open bucket
+    mongo_reading_t pending[MONGO_BUCKET_PENDING];
+    int pending_count;
+    int rejected;                           // flushes in a row the server rejected the upsert
+} mongo_bucket_series_t;
+
+typedef struct {
+    mongoc_collection_t *collection;
+    int64_t bucket_ms;
+    mongo_bucket_series_t series[MONGO_BUCKET_SERIES];
+    bson_t filter;                          // reused from upsert to upsert
+    bson_t update;
+    bson_t opts;
+    uint64_t readings;
+    uint64_t upserts;
+    uint64_t flushes;
+    uint64_t errors;
+    uint64_t lost;                          // readings without room or rejected too often
+    uint32_t dropped;                       // readings of series beyond MONGO_BUCKET_SERIES
+    bool failing;                           // the last flush failed
+    bson_error_t error;                     // of the last failure
+} mongo_bucket_writer_t;
+
+static inline void mongo_bucket_init(mongo_bucket_writer_t *writer, mongoc_collection_t *collection, int64_t bucket_ms) {
+    memset(writer, 0, sizeof(*writer));
+    writer->collection = collection;
+    writer->bucket_ms = bucket_ms;
+    bson_init(&writer->filter);
+    bson_init(&writer->update);
+    bson_init(&writer->opts);
+}
+
+static inline void mongo_bucket_free(mongo_bucket_writer_t *writer) {
+    bson_destroy(&writer->filter);
+    bson_destroy(&writer->update);
+    bson_destroy(&writer->opts);
+}
+
+// Upsert of the pending readings of one series into its bucket, an update
+// pipeline that only appends the readings newer than the bucket's end:
+//
+//   [ { $set: { id_type, device_id, sensor_type, start,
+//               readings: { $concatArrays: [ { $ifNull: [ "$readings", [] ] },
+//                                            { $filter: { input: [ pending ],
+//                                                         cond: { $gt: [ "$$this.t", "$end" ] } } } ] } } },
+//     { $set: { end: { $max: "$readings.t" }, count: { $size: "$readings" } } } ]
+static inline bool mongo_bucket_append_upsert(mongo_bucket_writer_t *writer, mongoc_bulk_operation_t *bulk,
+                                              const mongo_bucket_series_t *s) {
+    bson_t stage, set, expr, arrays, element, args, empty, filter, readings, reading, cond;
+    char id[96], index[16];
+    const char *key;
+
+    snprintf(id, sizeof(id), "%s/%s/%s/%lld", s->id_type, s->device_id, s->sensor_type, (long long)s->start_ms);
+
+    bson_reinit(&writer->filter);
+    BSON_APPEND_UTF8(&writer->filter, "_id", id);
+
+    bson_reinit(&writer->update);
+    BSON_APPEND_DOCUMENT_BEGIN(&writer->update, "0", &stage);
+    BSON_APPEND_DOCUMENT_BEGIN(&stage, "$set", &set);
+    BSON_APPEND_UTF8(&set, "id_type", s->id_type);
+    BSON_APPEND_UTF8(&set, "device_id", s->device_id);
+    BSON_APPEND_UTF8(&set, "sensor_type", s->sensor_type);
+    BSON_APPEND_DATE_TIME(&set, "start", s->start_ms);
+
+    BSON_APPEND_DOCUMENT_BEGIN(&set, "readings", &expr);
+    BSON_APPEND_ARRAY_BEGIN(&expr, "$concatArrays", &arrays);
+
+    BSON_APPEND_DOCUMENT_BEGIN(&arrays, "0", &element);
+    BSON_APPEND_ARRAY_BEGIN(&element, "$ifNull", &args);
+    BSON_APPEND_UTF8(&args, "0", "$readings");
+    BSON_APPEND_ARRAY_BEGIN(&args, "1", &empty);
+    bson_append_array_end(&args, &empty);
+    bson_append_array_end(&element, &args);
+    bson_append_document_end(&arrays, &element);
+
+    BSON_APPEND_DOCUMENT_BEGIN(&arrays, "1", &element);
+    BSON_APPEND_DOCUMENT_BEGIN(&element, "$filter", &filter);
+    BSON_APPEND_ARRAY_BEGIN(&filter, "input", &readings);
+    for (int i = 0; i < s->pending_count; i++) {
+        size_t key_len = bson_uint32_to_string((uint32_t)i, &key, index, sizeof(index));
+        bson_append_document_begin(&readings, key, (int)key_len, &reading);
+        BSON_APPEND_DATE_TIME(&reading, "t", s->pending[i].timestamp_ms);
+        for (int f = 0; f < s->field_count; f++) {
+            BSON_APPEND_DOUBLE(&reading, s->fields[f], s->pending[i].values[f]);
+        }
+        bson_append_document_end(&readings, &reading);
+    }
+    bson_append_array_end(&filter, &readings);
+    // A missing end sorts below every date
+    BSON_APPEND_DOCUMENT_BEGIN(&filter, "cond", &cond);
+    BSON_APPEND_ARRAY_BEGIN(&cond, "$gt", &args);
+    BSON_APPEND_UTF8(&args, "0", "$$this.t");
+    BSON_APPEND_UTF8(&args, "1", "$end");
+    bson_append_array_end(&cond, &args);
+    bson_append_document_end(&filter, &cond);
+    bson_append_document_end(&element, &filter);
+    bson_append_document_end(&arrays, &element);
+
+    bson_append_array_end(&expr, &arrays);
+    bson_append_document_end(&set, &expr);
+    bson_append_document_end(&stage, &set);
+    bson_append_document_end(&writer->update, &stage);
+
+    BSON_APPEND_DOCUMENT_BEGIN(&writer->update, "1", &stage);
+    BSON_APPEND_DOCUMENT_BEGIN(&stage, "$set", &set);
+    BSON_APPEND_DOCUMENT_BEGIN(&set, "end", &expr);
+    BSON_APPEND_UTF8(&expr, "$max", "$readings.t");
+    bson_append_document_end(&set, &expr);
+    BSON_APPEND_DOCUMENT_BEGIN(&set, "count", &expr);
+    BSON_APPEND_UTF8(&expr, "$size", "$readings");
+    bson_append_document_end(&set, &expr);
+    bson_append_document_end(&stage, &set);
+    bson_append_document_end(&writer->update, &stage);
+
+    bson_reinit(&writer->opts);
+    BSON_APPEND_BOOL(&writer->opts, "upsert", true);
+
+    return mongoc_bulk_operation_update_one_with_opts(bulk, &writer->filter, &writer->update, &writer->opts,
+                                                      &writer->error);
+}
+
+// Outcome of each upsert of a bulk
+typedef enum {
+    MONGO_BUCKET_APPLIED,
+    MONGO_BUCKET_KEPT,                      // not sent or the bulk did not get through
+    MONGO_BUCKET_REJECTED                   // refused by the server
+} mongo_bucket_result_t;
+
+// Positions errors on the first entry of a non-empty error array of the reply
+static inline bool mongo_bucket_reply_errors(const bson_t *reply, const char *name, bson_iter_t *errors) {
+    bson_iter_t iter;
+    return bson_iter_init_find(&iter, reply, name) && BSON_ITER_HOLDS_ARRAY(&iter) &&
+           bson_iter_recurse(&iter, errors) && bson_iter_next(errors);
+}
+
+// Results of the upserts of a failed bulk from its reply
+static inline void mongo_bucket_results(const bson_t *reply, uint32_t upserts, mongo_bucket_result_t *results) {
+    bson_iter_t errors, error;
+    bool write_errors = mongo_bucket_reply_errors(reply, "writeErrors", &errors);
+
+    // The bulk is unordered, the upserts not listed in writeErrors went
+    // through. With only a writeConcernError all of them were written, just
+    // not acknowledged as asked for. Without either the bulk did not get
+    // through, or it is unknown whether it did
+    bool applied = write_errors || mongo_bucket_reply_errors(reply, "writeConcernErrors", &error);
+    for (uint32_t i = 0; i < upserts; i++) {
+        results[i] = applied ? MONGO_BUCKET_APPLIED : MONGO_BUCKET_KEPT;
+    }
+    if (!write_errors) {
+        return;
+    }
+
+    do {
+        if (BSON_ITER_HOLDS_DOCUMENT(&errors) && bson_iter_recurse(&errors, &error) &&
+            bson_iter_find(&error, "index")) {
+            int64_t index = bson_iter_as_int64(&error);
+            if (index >= 0 && index < upserts) {
+                results[index] = MONGO_BUCKET_REJECTED;
+            }
+        }
+    } while (bson_iter_next(&errors));
+}
+
+/**
+ * @brief Write the pending readings of every series, one bulk
+ * @return false if the bulk failed, the readings of its failed upserts stay pending
+ */
+static inline bool mongo_bucket_flush(mongo_bucket_writer_t *writer) {
+    mongoc_bulk_operation_t *bulk = NULL;
+    mongo_bucket_series_t *written[MONGO_BUCKET_SERIES];
+    mongo_bucket_result_t results[MONGO_BUCKET_SERIES];
+    uint32_t upserts = 0, applied = 0;
+    bool ok = true, kept = false;
+
+    for (int i = 0; i < MONGO_BUCKET_SERIES && ok; i++) {
+        mongo_bucket_series_t *s = &writer->series[i];
+        if (!s->used || s->pending_count == 0) {
+            continue;
+        }
+        if (!bulk) {
+            bson_reinit(&writer->opts);
+            BSON_APPEND_BOOL(&writer->opts, "ordered", false);
+            bulk = mongoc_collection_create_bulk_operation_with_opts(writer->collection, &writer->opts);
+        }
+        ok = mongo_bucket_append_upsert(writer, bulk, s);
+        results[upserts] = ok ? MONGO_BUCKET_KEPT : MONGO_BUCKET_REJECTED;
+        written[upserts++] = s;
+    }
+
+    if (!bulk) {
+        return true;
+    }
+
+    if (ok) {
+        bson_t reply;
+        ok = mongoc_bulk_operation_execute(bulk, &reply, &writer->error) != 0;
+        for (uint32_t i = 0; i < upserts; i++) {
+            results[i] = MONGO_BUCKET_APPLIED;
+        }
+        if (!ok) {
+            mongo_bucket_results(&reply, upserts, results);
+        }
+        bson_destroy(&reply);
+    }
+    mongoc_bulk_operation_destroy(bulk);
+
+    for (uint32_t i = 0; i < upserts; i++) {
+        mongo_bucket_series_t *s = written[i];
+        if (results[i] == MONGO_BUCKET_REJECTED && ++s->rejected >= MONGO_BUCKET_RETRIES) {
+            writer->lost += s->pending_count;
+            s->pending_count = 0;
+            s->rejected = 0;
+        } else if (results[i] == MONGO_BUCKET_APPLIED) {
+            s->pending_count = 0;
+            s->rejected = 0;
+            applied++;
+        } else {
+            kept = true;
+        }
+    }
+
+    writer->flushes++;
+    writer->upserts += applied;
+    if (!ok) {
+        writer->errors++;
+    }
+    writer->failing = kept;
+    return ok;
+}
+
+// Series by name, created with fields on first use
+static inline mongo_bucket_series_t *mongo_bucket_find(mongo_bucket_writer_t *writer, const char *id_type,
+                                                       uint8_t device_id, const char *sensor_type,
+                                                       const char *const *fields, int field_count) {
+    char device[8];
+    snprintf(device, sizeof(device), "%02X", device_id);
+
+    for (int i = 0; i < MONGO_BUCKET_SERIES; i++) {
+        mongo_bucket_series_t *s = &writer->series[i];
+        if (!s->used) {
+            s->used = true;
+            snprintf(s->id_type, sizeof(s->id_type), "%s", id_type);
+            snprintf(s->device_id, sizeof(s->device_id), "%s", device);
+            snprintf(s->sensor_type, sizeof(s->sensor_type), "%s", sensor_type);
+            s->fields = fields;
+            s->field_count = field_count < MONGO_BUCKET_FIELDS ? field_count : MONGO_BUCKET_FIELDS;
+            s->pending_count = 0;
+            return s;
+        }
+        if (strcmp(s->device_id, device) == 0 && strcmp(s->id_type, id_type) == 0 &&
+            strcmp(s->sensor_type, sensor_type) == 0) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Add one reading to the bucket of its series
+ * @param fields names of values, must outlive the writer
+ * @return false if the series table is full or a flush it needed failed,
+ *         error tells which
+ */
+static inline bool mongo_bucket_add(mongo_bucket_writer_t *writer, const char *id_type, uint8_t device_id,
+                                    const char *sensor_type, const char *const *fields, int field_count,
+                                    int64_t timestamp_ms, const double *values) {
+    mongo_bucket_series_t *s = mongo_bucket_find(writer, id_type, device_id, sensor_type, fields, field_count);
+    int64_t start_ms = timestamp_ms - timestamp_ms % writer->bucket_ms;
+    bool ok = true;
+
+    if (!s) {
+        writer->dropped++;
+        bson_set_error(&writer->error, 0, 0, "more than %d series", MONGO_BUCKET_SERIES);
+        return false;
+    }
+
+    if (s->pending_count > 0 && (start_ms != s->start_ms || s->pending_count == MONGO_BUCKET_PENDING)) {
+        // While flushes fail the retry is left to the next mongo_bucket_flush()
+        ok = !writer->failing && mongo_bucket_flush(writer);
+        // The pending readings are kept for that retry, this one has no room
+        if (s->pending_count > 0) {
+            writer->lost++;
+            return false;
+        }
+    }
+    if (s->pending_count == 0) {
+        s->start_ms = start_ms;
+    }
+
+    mongo_reading_t *reading = &s->pending[s->pending_count++];
+    reading->timestamp_ms = timestamp_ms;
+    for (int f = 0; f < s->field_count; f++) {
+        reading->values[f] = values[f];
+    }
+    writer->readings++;
+    return ok;
+}
+
+#endif // MONGO_BUCKET_H
@@ -0,0 +1,247 @@
+/**
+ * @file series_compress.h
+ * @brief Report by exception compression per sensor series
+ * @version 1.0
+ * @date 2026
+ *
+ * Decides which readings of a series have to be stored so that the series
+ * can be rebuilt within a fixed error:
+ *
+ *   SERIES_COMPRESS_DEADBAND        a reading is kept when it leaves the band
+ *                                   around the last kept value, rebuild by
+ *                                   holding the last kept value
+ *   SERIES_COMPRESS_SWINGING_DOOR   a point is kept when no straight line
+ *                                   from the last kept point stays within the
+ *                                   band of all readings since, rebuild by
+ *                                   linear interpolation between kept points.
+ *                                   The point is put on the last line that
+ *                                   did, so it may differ from the reading at
+ *                                   that time by up to the band
+ *
+ * The band is max(deviation, percent / 100 * |reference value|). Either way
+ * every reading is within the band of the rebuilt series, and the first
+ * reading max_silence_ms or more after the last kept point is kept as well,
+ * so a steady series still shows that the sensor is alive.
+ *
+ * Keys use the layout of series_stats.h. Samples in and points out are
+ * counted per series for the compression ratio.
+ */
+
+#ifndef SERIES_COMPRESS_H
+#define SERIES_COMPRESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "series_stats.h"
+
+#ifndef SERIES_COMPRESS_MAX
+#define SERIES_COMPRESS_MAX     64          // series per table, power of two
+#endif
+#define SERIES_COMPRESS_MAX_FIELDS 16       // per series_compress_record()
+
+typedef enum {
+    SERIES_COMPRESS_NONE,                   // every reading is kept
+    SERIES_COMPRESS_DEADBAND,
+    SERIES_COMPRESS_SWINGING_DOOR
+} series_compress_mode_t;
+
+typedef struct {
+    series_compress_mode_t mode;
+    double deviation;                       // absolute band
+    double percent;                         // band relative to the reference value
+    int64_t max_silence_ms;                 // 0 for no limit
+} series_compress_config_t;
+
+typedef struct {
+    int64_t timestamp_ms;
+    double value;
+} series_point_t;
+
+typedef struct {
+    bool used;
+    uint32_t key;
+    const series_compress_config_t *config;
+    bool started;
+    series_point_t kept;                    // last kept point
+    series_point_t held;                    // last reading (swinging door)
+    double slope_low;                       // door slopes from kept, per ms
+    double slope_high;
+    uint64_t samples;
+    uint64_t points;
+} series_compressor_t;
+
+typedef struct {
+    series_compressor_t series[SERIES_COMPRESS_MAX];
+    uint32_t dropped;                       // readings of series beyond SERIES_COMPRESS_MAX
+} series_compress_t;
+
+static inline double series_compress_band(const series_compress_config_t *config, double reference) {
+    double band = config->percent / 100.0 * fabs(reference);
+    return band > config->deviation ? band : config->deviation;
+}
+
+/**
+ * @brief Compressor of a series, created with config on first use
+ * @return NULL if the table is full
+ */
+static inline series_compressor_t *series_compress_find(series_compress_t *table, uint32_t key,
+                                                 const series_compress_config_t *config) {
+    uint32_t slot = (key * 2654435761u) & (SERIES_COMPRESS_MAX - 1);
+
+    for (uint32_t probe = 0; probe < SERIES_COMPRESS_MAX; probe++) {
+        series_compressor_t *c = &table->series[(slot + probe) & (SERIES_COMPRESS_MAX - 1)];
+
+        if (c->used && c->key == key) {
+            return c;
+        }
+        if (!c->used) {
+            memset(c, 0, sizeof(*c));
+            c->used = true;
+            c->key = key;
+            c->config = config;
+            return c;
+        }
+    }
+
+    table->dropped++;
+    return NULL;
+}
+
+static inline void series_compress_keep(series_compressor_t *c, series_point_t point, series_point_t *out, int *count) {
+    c->kept = point;
+    c->slope_low = -INFINITY;
+    c->slope_high = INFINITY;
+    c->points++;
+    out[(*count)++] = point;
+}
+
+// Narrow the doors from the kept point by one reading
+static inline void series_compress_doors(series_compressor_t *c, series_point_t point) {
+    double band = series_compress_band(c->config, c->kept.value);
+    double dt = (double)(point.timestamp_ms > c->kept.timestamp_ms ? point.timestamp_ms - c->kept.timestamp_ms : 1);
+    double low = (point.value - band - c->kept.value) / dt;
+    double high = (point.value + band - c->kept.value) / dt;
+
+    if (low > c->slope_low) c->slope_low = low;
+    if (high < c->slope_high) c->slope_high = high;
+}
+
+// Point at the time of reading on the line from the kept point closest to it
+// within the doors, so that the line stays within the band of every reading
+// since the kept point, the reading itself included
+static inline series_point_t series_compress_on_doors(const series_compressor_t *c, series_point_t reading,
+                                                      double slope_low, double slope_high) {
+    double dt = (double)(reading.timestamp_ms > c->kept.timestamp_ms ? reading.timestamp_ms - c->kept.timestamp_ms : 1);
+    double slope = (reading.value - c->kept.value) / dt;
+
+    if (slope < slope_low) slope = slope_low;
+    if (slope > slope_high) slope = slope_high;
+
+    series_point_t point = { reading.timestamp_ms, c->kept.value + slope * dt };
+    return point;
+}
+
+/**
+ * @brief Feed one reading
+ * @param out receives the points to store, in time order
+ * @return number of points in out, 0 to 2
+ */
+static inline int series_compress_add(series_compressor_t *c, int64_t timestamp_ms, double value, series_point_t out[2]) {
+    const series_compress_config_t *config = c->config;
+    series_point_t point = { timestamp_ms, value };
+    int count = 0;
+
+    c->samples++;
+
+    if (!c->started || config->mode == SERIES_COMPRESS_NONE) {
+        c->started = true;
+        c->held = point;
+        series_compress_keep(c, point, out, &count);
+        return count;
+    }
+
+    bool silent = config->max_silence_ms > 0 && timestamp_ms - c->kept.timestamp_ms >= config->max_silence_ms;
+
+    if (config->mode == SERIES_COMPRESS_DEADBAND) {
+        if (silent || fabs(value - c->kept.value) > series_compress_band(config, c->kept.value)) {
+            series_compress_keep(c, point, out, &count);
+        }
+        return count;
+    }
+
+    // Swinging door: the held reading becomes a kept point once the doors
+    // through this reading have opened past parallel
+    double slope_low = c->slope_low;
+    double slope_high = c->slope_high;
+
+    series_compress_doors(c, point);
+    if (c->slope_low > c->slope_high) {
+        series_compress_keep(c, series_compress_on_doors(c, c->held, slope_low, slope_high), out, &count);
+        series_compress_doors(c, point);
+        silent = config->max_silence_ms > 0 && timestamp_ms - c->kept.timestamp_ms >= config->max_silence_ms;
+    }
+
+    if (silent) {
+        series_compress_keep(c, series_compress_on_doors(c, point, c->slope_low, c->slope_high), out, &count);
+    }
+
+    c->held = point;
+    return count;
+}
+
+/**
+ * @brief Deadband over the fields of one record, e.g. one line protocol point
+ *
+ * The record is kept as a whole when any field leaves its band or the silence
+ * limit is reached, so each field keeps the guarantee of its own deadband.
+ * Fields are looked up as keys[i] with config, which must use the deadband,
+ * up to SERIES_COMPRESS_MAX_FIELDS of them.
+ *
+ * @return true if the record has to be stored
+ */
+static inline bool series_compress_record(series_compress_t *table, const uint32_t *keys, const double *values, int fields,
+                                   const series_compress_config_t *config, int64_t timestamp_ms) {
+    series_compressor_t *c[SERIES_COMPRESS_MAX_FIELDS];
+    bool keep = false;
+
+    if (fields > SERIES_COMPRESS_MAX_FIELDS) {
+        return true;
+    }
+
+    for (int i = 0; i < fields; i++) {
+        c[i] = series_compress_find(table, keys[i], config);
+        if (!c[i]) {
+            return true;
+        }
+
+        c[i]->samples++;
+        if (!c[i]->started || config->mode == SERIES_COMPRESS_NONE ||
+            (config->max_silence_ms > 0 && timestamp_ms - c[i]->kept.timestamp_ms >= config->max_silence_ms) ||
+            fabs(values[i] - c[i]->kept.value) > series_compress_band(config, c[i]->kept.value)) {
+            keep = true;
+        }
+    }
+
+    if (keep) {
+        for (int i = 0; i < fields; i++) {
+            c[i]->started = true;
+            c[i]->kept.timestamp_ms = timestamp_ms;
+            c[i]->kept.value = values[i];
+            c[i]->held = c[i]->kept;
+            c[i]->points++;
+        }
+    }
+    return keep;
+}
+
+/**
+ * @brief Readings per stored point, 1.0 without compression
+ */
+static inline double series_compress_ratio(const series_compressor_t *c) {
+    return c->points ? (double)c->samples / c->points : 0.0;
+}
+
+#endif // SERIES_COMPRESS_H
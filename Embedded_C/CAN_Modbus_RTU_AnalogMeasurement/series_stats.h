@@ -0,0 +1,480 @@
+/**
+ * @file series_stats.h
+ * @brief Windowed streaming statistics per sensor series
+ * @version 1.0
+ * @date 2026
+ *
+ * Samples are keyed by origin (CAN or RTU), source node, CAN_bus.h message
+ * type and field. Every series keeps up to SERIES_MAX_PANES panes of pane_ms; a
+ * window is the merge of the last `panes` panes, so panes == 1 gives tumbling
+ * windows and panes > 1 sliding windows advancing by one pane. Per pane:
+ *
+ *   count, min, max     exact
+ *   mean, stddev        Welford, panes merged with Chan's parallel formula
+ *   percentiles         DDSketch with relative accuracy SERIES_SKETCH_ALPHA in
+ *                       SERIES_SKETCH_BUCKETS buckets per sign, the lowest
+ *                       buckets collapse once the values span more than that
+ *
+ * Memory per series is fixed, whatever the sample rate. At the end of every
+ * pane series_stats_advance() hands one aggregate per active series to the
+ * sink callback. The raw samples stay in a fixed size ring for local queries.
+ */
+
+#ifndef SERIES_STATS_H
+#define SERIES_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* ========================================================================== */
+/*                              CONFIGURATION                                */
+/* ========================================================================== */
+
+#ifndef SERIES_MAX
+#define SERIES_MAX              64          // series per engine, power of two
+#endif
+#define SERIES_MAX_PANES        12
+#define SERIES_SKETCH_ALPHA     0.02        // relative error of the percentiles
+#define SERIES_SKETCH_BUCKETS   128         // per sign, spans about 1:160 at 2%
+#define SERIES_SKETCH_MIN       1e-9        // smaller magnitudes count as zero
+
+// Key layout: origin << 24 | source node << 16 | message type << 8 | field
+#define SERIES_ORIGIN_CAN       0
+#define SERIES_ORIGIN_RTU       1
+#define SERIES_KEY(origin, node, type, field) \
+    (((uint32_t)(origin) << 24) | ((uint32_t)((node) & 0xFF) << 16) | \
+     ((uint32_t)((type) & 0xFF) << 8) | ((uint32_t)((field) & 0xFF)))
+#define SERIES_KEY_ORIGIN(key)  (((key) >> 24) & 0xFF)
+#define SERIES_KEY_NODE(key)    (((key) >> 16) & 0xFF)
+#define SERIES_KEY_TYPE(key)    (((key) >> 8) & 0xFF)
+#define SERIES_KEY_FIELD(key)   ((key) & 0xFF)
+
+/* ========================================================================== */
+/*                                  TYPES                                    */
+/* ========================================================================== */
+
+typedef struct {
+    int32_t offset;                 // key of counts[0]
+    uint32_t total;
+    uint32_t counts[SERIES_SKETCH_BUCKETS];
+} series_sketch_store_t;
+
+typedef struct {
+    series_sketch_store_t positive;
+    series_sketch_store_t negative; // keyed by magnitude
+    uint32_t zero;
+} series_sketch_t;
+
+typedef struct {
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double m2;                      // sum of squared differences from the mean
+    series_sketch_t sketch;
+} series_moments_t;
+
+typedef struct {
+    uint32_t key;
+    int64_t window_start_ms;
+    int64_t window_end_ms;
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double stddev;                  // sample standard deviation
+    double p50;
+    double p90;
+    double p99;
+} series_aggregate_t;
+
+typedef struct {
+    bool used;
+    uint32_t key;
+    // One slot more than panes, the pane being filled must not evict the
+    // oldest pane of the window still to be emitted
+    int64_t epochs[SERIES_MAX_PANES + 1];   // pane number held by each slot
+    series_moments_t panes[SERIES_MAX_PANES + 1];
+} series_t;
+
+typedef struct {
+    int64_t timestamp_ms;
+    uint32_t key;
+    float value;
+} series_sample_t;
+
+typedef struct {
+    series_sample_t *samples;
+    uint32_t capacity;              // power of two
+    uint64_t written;
+} series_raw_ring_t;
+
+typedef void (*series_sink_t)(const series_aggregate_t *aggregate, void *context);
+
+typedef struct {
+    int64_t pane_ms;
+    uint32_t panes;                 // per window
+    int64_t last_epoch;             // last pane handed to the sink
+    bool started;
+    uint32_t dropped;               // samples of series beyond SERIES_MAX
+    series_raw_ring_t raw;
+    series_t series[SERIES_MAX];
+} series_stats_t;
+
+/* ========================================================================== */
+/*                                 SKETCH                                    */
+/* ========================================================================== */
+
+static const double series_sketch_gamma = (1.0 + SERIES_SKETCH_ALPHA) / (1.0 - SERIES_SKETCH_ALPHA);
+
+static inline int32_t series_sketch_key(double magnitude) {
+    return (int32_t)ceil(log(magnitude) / log(series_sketch_gamma));
+}
+
+static inline double series_sketch_value(int32_t key) {
+    return 2.0 * pow(series_sketch_gamma, key) / (series_sketch_gamma + 1.0);
+}
+
+static inline void series_sketch_store_add(series_sketch_store_t *store, int32_t key, uint32_t count) {
+    if (store->total == 0) {
+        memset(store->counts, 0, sizeof(store->counts));
+        store->offset = key - SERIES_SKETCH_BUCKETS / 2;
+    }
+
+    if (key < store->offset) {
+        int32_t highest = store->offset + SERIES_SKETCH_BUCKETS - 1;
+        while (highest >= store->offset && store->counts[highest - store->offset] == 0) {
+            highest--;
+        }
+
+        if (highest - key < SERIES_SKETCH_BUCKETS) {
+            // Slide the buckets up, nothing is lost
+            int32_t shift = store->offset - key;
+            memmove(&store->counts[shift], store->counts,
+                    (SERIES_SKETCH_BUCKETS - shift) * sizeof(uint32_t));
+            memset(store->counts, 0, shift * sizeof(uint32_t));
+            store->offset = key;
+        } else {
+            key = store->offset;
+        }
+    } else if (key >= store->offset + SERIES_SKETCH_BUCKETS) {
+        // Slide the buckets down, the lowest collapse into the new first one
+        int32_t shift = key - (store->offset + SERIES_SKETCH_BUCKETS - 1);
+        uint32_t collapsed = 0;
+
+        if (shift >= SERIES_SKETCH_BUCKETS) {
+            collapsed = store->total;
+            memset(store->counts, 0, sizeof(store->counts));
+        } else {
+            for (int32_t i = 0; i <= shift; i++) {
+                collapsed += store->counts[i];
+            }
+            memmove(store->counts, &store->counts[shift],
+                    (SERIES_SKETCH_BUCKETS - shift) * sizeof(uint32_t));
+            memset(&store->counts[SERIES_SKETCH_BUCKETS - shift], 0, shift * sizeof(uint32_t));
+        }
+
+        store->counts[0] = collapsed;
+        store->offset += shift;
+    }
+
+    store->counts[key - store->offset] += count;
+    store->total += count;
+}
+
+static inline void series_sketch_add(series_sketch_t *sketch, double value) {
+    if (value > SERIES_SKETCH_MIN) {
+        series_sketch_store_add(&sketch->positive, series_sketch_key(value), 1);
+    } else if (value < -SERIES_SKETCH_MIN) {
+        series_sketch_store_add(&sketch->negative, series_sketch_key(-value), 1);
+    } else {
+        sketch->zero++;
+    }
+}
+
+static inline void series_sketch_merge(series_sketch_t *into, const series_sketch_t *from) {
+    for (int i = 0; i < SERIES_SKETCH_BUCKETS; i++) {
+        if (from->positive.total && from->positive.counts[i]) {
+            series_sketch_store_add(&into->positive, from->positive.offset + i, from->positive.counts[i]);
+        }
+        if (from->negative.total && from->negative.counts[i]) {
+            series_sketch_store_add(&into->negative, from->negative.offset + i, from->negative.counts[i]);
+        }
+    }
+    into->zero += from->zero;
+}
+
+// Value at quantile q (0..1), within SERIES_SKETCH_ALPHA of the exact one
+static inline double series_sketch_quantile(const series_sketch_t *sketch, double q) {
+    uint64_t total = (uint64_t)sketch->negative.total + sketch->zero + sketch->positive.total;
+    if (total == 0) {
+        return NAN;
+    }
+
+    double rank = q * (total - 1);
+    uint64_t seen = 0;
+
+    // Most negative first
+    if (sketch->negative.total) {
+        for (int i = SERIES_SKETCH_BUCKETS - 1; i >= 0; i--) {
+            seen += sketch->negative.counts[i];
+            if (seen > rank) {
+                return -series_sketch_value(sketch->negative.offset + i);
+            }
+        }
+    }
+
+    seen += sketch->zero;
+    if (seen > rank) {
+        return 0.0;
+    }
+
+    for (int i = 0; i < SERIES_SKETCH_BUCKETS; i++) {
+        seen += sketch->positive.counts[i];
+        if (seen > rank) {
+            return series_sketch_value(sketch->positive.offset + i);
+        }
+    }
+
+    return series_sketch_value(sketch->positive.offset + SERIES_SKETCH_BUCKETS - 1);
+}
+
+/* ========================================================================== */
+/*                                 MOMENTS                                   */
+/* ========================================================================== */
+
+static inline void series_moments_reset(series_moments_t *m) {
+    m->count = 0;
+    m->mean = 0.0;
+    m->m2 = 0.0;
+    m->sketch.positive.total = 0;
+    m->sketch.negative.total = 0;
+    m->sketch.zero = 0;
+}
+
+static inline void series_moments_add(series_moments_t *m, double value) {
+    if (m->count == 0) {
+        m->min = value;
+        m->max = value;
+    } else {
+        if (value < m->min) m->min = value;
+        if (value > m->max) m->max = value;
+    }
+
+    m->count++;
+    double delta = value - m->mean;
+    m->mean += delta / m->count;
+    m->m2 += delta * (value - m->mean);
+
+    series_sketch_add(&m->sketch, value);
+}
+
+static inline void series_moments_merge(series_moments_t *into, const series_moments_t *from) {
+    if (from->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *from;
+        return;
+    }
+
+    double n = (double)into->count + from->count;
+    double delta = from->mean - into->mean;
+
+    into->mean += delta * from->count / n;
+    into->m2 += from->m2 + delta * delta * into->count * from->count / n;
+    into->count += from->count;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+
+    series_sketch_merge(&into->sketch, &from->sketch);
+}
+
+/* ========================================================================== */
+/*                                 ENGINE                                    */
+/* ========================================================================== */
+
+/**
+ * @brief Set up an engine, windows of panes * pane_ms advancing by pane_ms
+ * @param raw_capacity raw samples kept, rounded down to a power of two
+ */
+static inline bool series_stats_init(series_stats_t *stats, int64_t pane_ms, uint32_t panes, uint32_t raw_capacity) {
+    memset(stats, 0, sizeof(*stats));
+
+    if (pane_ms <= 0 || panes == 0 || panes > SERIES_MAX_PANES) {
+        return false;
+    }
+
+    stats->pane_ms = pane_ms;
+    stats->panes = panes;
+
+    while (raw_capacity & (raw_capacity - 1)) {
+        raw_capacity &= raw_capacity - 1;
+    }
+    stats->raw.capacity = raw_capacity;
+    stats->raw.samples = raw_capacity ? calloc(raw_capacity, sizeof(series_sample_t)) : NULL;
+
+    return raw_capacity == 0 || stats->raw.samples != NULL;
+}
+
+static inline void series_stats_free(series_stats_t *stats) {
+    free(stats->raw.samples);
+    stats->raw.samples = NULL;
+    stats->raw.capacity = 0;
+}
+
+static inline series_t *series_stats_find(series_stats_t *stats, uint32_t key, bool create) {
+    uint32_t slot = (key * 2654435761u) & (SERIES_MAX - 1);
+
+    for (uint32_t probe = 0; probe < SERIES_MAX; probe++) {
+        series_t *series = &stats->series[(slot + probe) & (SERIES_MAX - 1)];
+
+        if (series->used && series->key == key) {
+            return series;
+        }
+        if (!series->used) {
+            if (!create) {
+                return NULL;
+            }
+            series->used = true;
+            series->key = key;
+            for (int i = 0; i <= SERIES_MAX_PANES; i++) {
+                series->epochs[i] = -1;
+            }
+            return series;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Add one sample, also kept in the raw ring
+ */
+static inline void series_stats_add(series_stats_t *stats, uint32_t key, int64_t timestamp_ms, double value) {
+    if (stats->raw.capacity) {
+        series_sample_t *sample = &stats->raw.samples[stats->raw.written & (stats->raw.capacity - 1)];
+        sample->timestamp_ms = timestamp_ms;
+        sample->key = key;
+        sample->value = (float)value;
+        stats->raw.written++;
+    }
+
+    series_t *series = series_stats_find(stats, key, true);
+    if (!series) {
+        stats->dropped++;
+        return;
+    }
+
+    int64_t epoch = timestamp_ms / stats->pane_ms;
+    uint32_t slot = (uint32_t)(epoch % (stats->panes + 1));
+
+    if (series->epochs[slot] != epoch) {
+        // Samples of panes already handed to the sink are not counted again
+        if (epoch < series->epochs[slot] || (stats->started && epoch <= stats->last_epoch)) {
+            return;
+        }
+        series_moments_reset(&series->panes[slot]);
+        series->epochs[slot] = epoch;
+    }
+
+    series_moments_add(&series->panes[slot], value);
+}
+
+/**
+ * @brief Merge the panes of the window ending with pane `epoch`
+ * @return false if the series had no samples in the window
+ */
+static inline bool series_stats_window(const series_stats_t *stats, const series_t *series, int64_t epoch,
+                                series_aggregate_t *out) {
+    static series_moments_t merged;   // too large for small stacks
+
+    series_moments_reset(&merged);
+    for (uint32_t slot = 0; slot <= stats->panes; slot++) {
+        int64_t pane = series->epochs[slot];
+        if (pane > epoch - (int64_t)stats->panes && pane <= epoch) {
+            series_moments_merge(&merged, &series->panes[slot]);
+        }
+    }
+
+    if (merged.count == 0) {
+        return false;
+    }
+
+    out->key = series->key;
+    out->window_start_ms = (epoch - stats->panes + 1) * stats->pane_ms;
+    out->window_end_ms = (epoch + 1) * stats->pane_ms;
+    out->count = merged.count;
+    out->min = merged.min;
+    out->max = merged.max;
+    out->mean = merged.mean;
+    out->stddev = merged.count > 1 ? sqrt(merged.m2 / (merged.count - 1)) : 0.0;
+    out->p50 = series_sketch_quantile(&merged.sketch, 0.50);
+    out->p90 = series_sketch_quantile(&merged.sketch, 0.90);
+    out->p99 = series_sketch_quantile(&merged.sketch, 0.99);
+
+    // Percentiles within the exact bounds
+    if (out->p50 < out->min) out->p50 = out->min;
+    if (out->p90 < out->min) out->p90 = out->min;
+    if (out->p99 < out->min) out->p99 = out->min;
+    if (out->p50 > out->max) out->p50 = out->max;
+    if (out->p90 > out->max) out->p90 = out->max;
+    if (out->p99 > out->max) out->p99 = out->max;
+    return true;
+}
+
+/**
+ * @brief Hand the windows of all completed panes up to now_ms to the sink
+ * @return number of aggregates emitted
+ */
+static inline int series_stats_advance(series_stats_t *stats, int64_t now_ms, series_sink_t sink, void *context) {
+    int64_t completed = now_ms / stats->pane_ms - 1;
+    int emitted = 0;
+
+    if (!stats->started) {
+        stats->started = true;
+        stats->last_epoch = completed;
+        return 0;
+    }
+
+    // After a long pause only the latest window is of interest
+    if (completed - stats->last_epoch > (int64_t)stats->panes) {
+        stats->last_epoch = completed - 1;
+    }
+
+    while (stats->last_epoch < completed) {
+        stats->last_epoch++;
+
+        for (int i = 0; i < SERIES_MAX; i++) {
+            series_aggregate_t aggregate;
+            if (stats->series[i].used &&
+                series_stats_window(stats, &stats->series[i], stats->last_epoch, &aggregate)) {
+                sink(&aggregate, context);
+                emitted++;
+            }
+        }
+    }
+    return emitted;
+}
+
+/**
+ * @brief Raw samples of a series between from_ms and to_ms, oldest first
+ * @return number of samples copied to out
+ */
+static inline uint32_t series_stats_raw(const series_stats_t *stats, uint32_t key, int64_t from_ms, int64_t to_ms,
+                                 series_sample_t *out, uint32_t max) {
+    uint64_t held = stats->raw.written < stats->raw.capacity ? stats->raw.written : stats->raw.capacity;
+    uint32_t copied = 0;
+
+    for (uint64_t i = stats->raw.written - held; i < stats->raw.written && copied < max; i++) {
+        const series_sample_t *sample = &stats->raw.samples[i & (stats->raw.capacity - 1)];
+        if (sample->key == key && sample->timestamp_ms >= from_ms && sample->timestamp_ms <= to_ms) {
+            out[copied++] = *sample;
+        }
+    }
+    return copied;
+}
+
+#endif // SERIES_STATS_H
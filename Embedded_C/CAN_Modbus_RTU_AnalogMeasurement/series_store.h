@@ -0,0 +1,721 @@
+/**
+ * @file series_store.h
+ * @brief Local time series store with Gorilla compression
+ * @version 1.0
+ * @date 2026
+ *
+ * All readings of the gateway are kept in one memory mapped file of fixed
+ * size, split into blocks of SERIES_STORE_BLOCK_SIZE bytes. A block belongs
+ * to one series and holds two columns growing towards each other:
+ *
+ *   timestamps   from the front, delta of delta in ms with the variable
+ *                length prefixes of Gorilla ('0', '10' + 7 bits, '110' + 9,
+ *                '1110' + 12, '1111' + 64)
+ *   values       from the back, XOR with the previous value: '0' for the
+ *                same value, '10' + the meaningful bits within the previous
+ *                leading/trailing zero window, '11' + 5 bits of leading zeros,
+ *                6 bits of length and the meaningful bits
+ *
+ * The block header keeps the first point and count/min/max/sum/last, so a
+ * downsample query takes whole blocks within one bucket from the header
+ * without decoding them.
+ *
+ * Blocks are handed out round robin. Once the file is full the oldest block
+ * is reused, which is always the oldest block of its series, so retention
+ * is simply the size of the file. On open the series chains are rebuilt
+ * from the block headers in allocation order, and the encoder of the last
+ * block of each series from its contents.
+ *
+ * Timestamps of a series must not decrease. A single thread appends and
+ * queries.
+ */
+
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ========================================================================== */
+/*                              CONFIGURATION                                */
+/* ========================================================================== */
+
+#define SERIES_STORE_MAGIC          0x53545747u     // "GWTS"
+#define SERIES_STORE_VERSION        1
+#define SERIES_STORE_BLOCK_SIZE     4096
+#define SERIES_STORE_HEADER_SIZE    96
+#define SERIES_STORE_DATA_BITS      ((SERIES_STORE_BLOCK_SIZE - SERIES_STORE_HEADER_SIZE) * 8)
+#define SERIES_STORE_POINT_BITS_MAX (68 + 77)       // worst case timestamp + value
+#define SERIES_STORE_NONE           0xFFFFFFFFu
+#ifndef SERIES_STORE_MAX_SERIES
+#define SERIES_STORE_MAX_SERIES     128             // power of two
+#endif
+
+/* ========================================================================== */
+/*                                  TYPES                                    */
+/* ========================================================================== */
+
+typedef struct {
+    uint32_t magic;                 // SERIES_STORE_MAGIC while in use
+    uint32_t key;
+    uint64_t seq;                   // allocation order
+    int64_t first_ts;
+    int64_t last_ts;
+    double first_value;
+    double last_value;
+    double min;
+    double max;
+    double sum;
+    uint32_t count;
+    uint32_t ts_bits;               // used bits of the timestamp column
+    uint32_t value_bits;            // used bits of the value column
+    uint32_t reserved[3];
+    uint8_t data[SERIES_STORE_BLOCK_SIZE - SERIES_STORE_HEADER_SIZE];
+} series_store_block_t;
+
+typedef char series_store_block_size_check[sizeof(series_store_block_t) == SERIES_STORE_BLOCK_SIZE ? 1 : -1];
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t block_size;
+    uint32_t blocks;
+    uint8_t reserved[SERIES_STORE_BLOCK_SIZE - 16];
+} series_store_file_t;
+
+typedef struct {
+    bool used;
+    uint32_t key;
+    uint32_t head;                  // oldest block
+    uint32_t tail;                  // block being appended to
+    uint32_t blocks;
+    uint64_t points;
+    // Encoder state after the last point of tail
+    int64_t delta;
+    uint64_t bits;
+    uint8_t leading;
+    uint8_t trailing;               // 64 for no window yet
+} series_store_series_t;
+
+typedef struct {
+    int fd;
+    size_t size;
+    series_store_file_t *file;
+    series_store_block_t *blocks;
+    uint32_t block_count;
+    uint32_t *next;                 // next block of the same series
+    uint32_t next_alloc;
+    uint64_t seq;
+    uint32_t dropped;               // points refused (series table full, time going back)
+    series_store_series_t series[SERIES_STORE_MAX_SERIES];
+} series_store_t;
+
+typedef struct {
+    int64_t timestamp_ms;
+    double value;
+} series_store_point_t;
+
+typedef struct {
+    int64_t start_ms;
+    uint32_t count;
+    double min;
+    double max;
+    double sum;
+    double first;
+    double last;
+} series_store_bucket_t;
+
+typedef struct {
+    const series_store_block_t *block;
+    uint32_t index;
+    uint32_t ts_pos;
+    uint32_t value_pos;
+    int64_t ts;
+    int64_t delta;
+    uint64_t bits;
+    uint8_t leading;
+    uint8_t trailing;
+} series_store_iter_t;
+
+/* ========================================================================== */
+/*                                BIT COLUMNS                                */
+/* ========================================================================== */
+
+// Bit pos of the timestamp column lives in data[pos / 8], of the value column
+// in data[last - pos / 8], most significant bit first in both
+static inline uint8_t *series_store_byte(uint8_t *data, bool backwards, uint32_t pos) {
+    return backwards ? &data[sizeof(((series_store_block_t *)0)->data) - 1 - (pos >> 3)] : &data[pos >> 3];
+}
+
+static inline void series_store_put(uint8_t *data, bool backwards, uint32_t *pos, uint64_t value, uint32_t count) {
+    while (count) {
+        uint32_t room = 8 - (*pos & 7);
+        uint32_t take = count < room ? count : room;
+        uint8_t chunk = (uint8_t)((value >> (count - take)) & ((1u << take) - 1));
+
+        *series_store_byte(data, backwards, *pos) |= (uint8_t)(chunk << (room - take));
+        *pos += take;
+        count -= take;
+    }
+}
+
+static inline uint64_t series_store_get(const uint8_t *data, bool backwards, uint32_t *pos, uint32_t count) {
+    uint64_t value = 0;
+
+    while (count) {
+        uint32_t room = 8 - (*pos & 7);
+        uint32_t take = count < room ? count : room;
+        uint8_t byte = *series_store_byte((uint8_t *)data, backwards, *pos);
+
+        value = (value << take) | ((byte >> (room - take)) & ((1u << take) - 1));
+        *pos += take;
+        count -= take;
+    }
+    return value;
+}
+
+static inline int64_t series_store_sign_extend(uint64_t value, uint32_t bits) {
+    uint64_t sign = 1ull << (bits - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+static inline uint64_t series_store_double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double series_store_bits_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* ========================================================================== */
+/*                                 DECODING                                  */
+/* ========================================================================== */
+
+static inline void series_store_iter_init(series_store_iter_t *it, const series_store_block_t *block) {
+    memset(it, 0, sizeof(*it));
+    it->block = block;
+    it->trailing = 64;
+}
+
+/**
+ * @brief Next point of the block, in time order
+ * @return false after the last point
+ */
+static inline bool series_store_iter_next(series_store_iter_t *it, series_store_point_t *point) {
+    const series_store_block_t *block = it->block;
+
+    if (it->index >= block->count) {
+        return false;
+    }
+
+    if (it->index++ == 0) {
+        it->ts = block->first_ts;
+        it->bits = series_store_double_bits(block->first_value);
+    } else {
+        // Delta of delta
+        int64_t dod = 0;
+        if (series_store_get(block->data, false, &it->ts_pos, 1)) {
+            if (!series_store_get(block->data, false, &it->ts_pos, 1)) {
+                dod = series_store_sign_extend(series_store_get(block->data, false, &it->ts_pos, 7), 7);
+            } else if (!series_store_get(block->data, false, &it->ts_pos, 1)) {
+                dod = series_store_sign_extend(series_store_get(block->data, false, &it->ts_pos, 9), 9);
+            } else if (!series_store_get(block->data, false, &it->ts_pos, 1)) {
+                dod = series_store_sign_extend(series_store_get(block->data, false, &it->ts_pos, 12), 12);
+            } else {
+                dod = (int64_t)series_store_get(block->data, false, &it->ts_pos, 64);
+            }
+        }
+        it->delta += dod;
+        it->ts += it->delta;
+
+        // XOR with the previous value
+        if (series_store_get(block->data, true, &it->value_pos, 1)) {
+            if (series_store_get(block->data, true, &it->value_pos, 1)) {
+                it->leading = (uint8_t)series_store_get(block->data, true, &it->value_pos, 5);
+                uint32_t length = (uint32_t)series_store_get(block->data, true, &it->value_pos, 6);
+                if (length == 0) {
+                    length = 64;
+                }
+                it->trailing = (uint8_t)(64 - it->leading - length);
+            }
+            uint32_t length = 64 - it->leading - it->trailing;
+            it->bits ^= series_store_get(block->data, true, &it->value_pos, length) << it->trailing;
+        }
+    }
+
+    point->timestamp_ms = it->ts;
+    point->value = series_store_bits_double(it->bits);
+    return true;
+}
+
+/* ========================================================================== */
+/*                                  BLOCKS                                   */
+/* ========================================================================== */
+
+static inline series_store_series_t *series_store_find(series_store_t *store, uint32_t key, bool create) {
+    uint32_t slot = (key * 2654435761u) & (SERIES_STORE_MAX_SERIES - 1);
+
+    for (uint32_t probe = 0; probe < SERIES_STORE_MAX_SERIES; probe++) {
+        series_store_series_t *series = &store->series[(slot + probe) & (SERIES_STORE_MAX_SERIES - 1)];
+
+        if (series->used && series->key == key) {
+            return series;
+        }
+        if (!series->used) {
+            if (!create) {
+                return NULL;
+            }
+            memset(series, 0, sizeof(*series));
+            series->used = true;
+            series->key = key;
+            series->head = SERIES_STORE_NONE;
+            series->tail = SERIES_STORE_NONE;
+            series->trailing = 64;
+            return series;
+        }
+    }
+    return NULL;
+}
+
+// Take the next block of the ring for series, dropping the oldest one if needed
+static inline series_store_block_t *series_store_new_block(series_store_t *store, series_store_series_t *series) {
+    uint32_t index = store->next_alloc;
+    series_store_block_t *block = &store->blocks[index];
+
+    store->next_alloc = (index + 1) % store->block_count;
+
+    if (block->magic == SERIES_STORE_MAGIC) {
+        series_store_series_t *owner = series_store_find(store, block->key, false);
+        if (owner && owner->head == index) {
+            owner->head = store->next[index];
+            if (owner->head == SERIES_STORE_NONE) {
+                owner->tail = SERIES_STORE_NONE;
+            }
+            owner->blocks--;
+            owner->points -= block->count;
+        }
+    }
+
+    memset(block, 0, sizeof(*block));
+    block->magic = SERIES_STORE_MAGIC;
+    block->key = series->key;
+    block->seq = store->seq++;
+
+    store->next[index] = SERIES_STORE_NONE;
+    if (series->tail != SERIES_STORE_NONE) {
+        store->next[series->tail] = index;
+    } else {
+        series->head = index;
+    }
+    series->tail = index;
+    series->blocks++;
+    return block;
+}
+
+/**
+ * @brief Append one point, timestamps of a series must not decrease
+ * @return false if the point was refused
+ */
+static inline bool series_store_append(series_store_t *store, uint32_t key, int64_t timestamp_ms, double value) {
+    series_store_series_t *series = series_store_find(store, key, true);
+    if (!series) {
+        store->dropped++;
+        return false;
+    }
+
+    series_store_block_t *block = series->tail != SERIES_STORE_NONE ? &store->blocks[series->tail] : NULL;
+
+    if (block && timestamp_ms < block->last_ts) {
+        store->dropped++;
+        return false;
+    }
+
+    if (!block || block->ts_bits + block->value_bits + SERIES_STORE_POINT_BITS_MAX > SERIES_STORE_DATA_BITS) {
+        block = series_store_new_block(store, series);
+        block->first_ts = timestamp_ms;
+        block->first_value = value;
+        block->min = value;
+        block->max = value;
+        series->delta = 0;
+        series->bits = series_store_double_bits(value);
+        series->leading = 0;
+        series->trailing = 64;
+    } else {
+        // Delta of delta
+        int64_t delta = timestamp_ms - block->last_ts;
+        int64_t dod = delta - series->delta;
+
+        if (dod == 0) {
+            series_store_put(block->data, false, &block->ts_bits, 0, 1);
+        } else if (dod >= -64 && dod <= 63) {
+            series_store_put(block->data, false, &block->ts_bits, 0x2, 2);
+            series_store_put(block->data, false, &block->ts_bits, (uint64_t)dod & 0x7F, 7);
+        } else if (dod >= -256 && dod <= 255) {
+            series_store_put(block->data, false, &block->ts_bits, 0x6, 3);
+            series_store_put(block->data, false, &block->ts_bits, (uint64_t)dod & 0x1FF, 9);
+        } else if (dod >= -2048 && dod <= 2047) {
+            series_store_put(block->data, false, &block->ts_bits, 0xE, 4);
+            series_store_put(block->data, false, &block->ts_bits, (uint64_t)dod & 0xFFF, 12);
+        } else {
+            series_store_put(block->data, false, &block->ts_bits, 0xF, 4);
+            series_store_put(block->data, false, &block->ts_bits, (uint64_t)dod, 64);
+        }
+        series->delta = delta;
+
+        // XOR with the previous value
+        uint64_t bits = series_store_double_bits(value);
+        uint64_t xor = bits ^ series->bits;
+
+        if (xor == 0) {
+            series_store_put(block->data, true, &block->value_bits, 0, 1);
+        } else {
+            uint32_t leading = (uint32_t)__builtin_clzll(xor);
+            uint32_t trailing = (uint32_t)__builtin_ctzll(xor);
+            if (leading > 31) {
+                leading = 31;
+            }
+
+            if (series->trailing < 64 && leading >= series->leading && trailing >= series->trailing) {
+                series_store_put(block->data, true, &block->value_bits, 0x2, 2);
+                series_store_put(block->data, true, &block->value_bits, xor >> series->trailing,
+                                 64 - series->leading - series->trailing);
+            } else {
+                uint32_t length = 64 - leading - trailing;
+                series_store_put(block->data, true, &block->value_bits, 0x3, 2);
+                series_store_put(block->data, true, &block->value_bits, leading, 5);
+                series_store_put(block->data, true, &block->value_bits, length & 0x3F, 6);
+                series_store_put(block->data, true, &block->value_bits, xor >> trailing, length);
+                series->leading = (uint8_t)leading;
+                series->trailing = (uint8_t)trailing;
+            }
+        }
+        series->bits = bits;
+
+        if (value < block->min) block->min = value;
+        if (value > block->max) block->max = value;
+    }
+
+    block->last_ts = timestamp_ms;
+    block->last_value = value;
+    block->sum += value;
+    block->count++;
+    series->points++;
+    return true;
+}
+
+/* ========================================================================== */
+/*                                OPEN / CLOSE                               */
+/* ========================================================================== */
+
+// Rebuild the series chains and encoders from the blocks in the file
+static inline void series_store_recover(series_store_t *store) {
+    uint32_t newest = SERIES_STORE_NONE;
+
+    for (uint32_t i = 0; i < store->block_count; i++) {
+        store->next[i] = SERIES_STORE_NONE;
+        if (store->blocks[i].magic == SERIES_STORE_MAGIC &&
+            (newest == SERIES_STORE_NONE || store->blocks[i].seq > store->blocks[newest].seq)) {
+            newest = i;
+        }
+    }
+    if (newest == SERIES_STORE_NONE) {
+        return;
+    }
+
+    // Blocks are handed out round robin, so the ring after the newest block
+    // is in allocation order
+    store->seq = store->blocks[newest].seq + 1;
+    store->next_alloc = (newest + 1) % store->block_count;
+
+    for (uint32_t n = 1; n <= store->block_count; n++) {
+        uint32_t index = (newest + n) % store->block_count;
+        series_store_block_t *block = &store->blocks[index];
+
+        if (block->magic != SERIES_STORE_MAGIC) {
+            continue;
+        }
+
+        series_store_series_t *series = series_store_find(store, block->key, true);
+        if (!series) {
+            block->magic = 0;
+            continue;
+        }
+        if (series->tail != SERIES_STORE_NONE) {
+            store->next[series->tail] = index;
+        } else {
+            series->head = index;
+        }
+        series->tail = index;
+        series->blocks++;
+        series->points += block->count;
+    }
+
+    // Encoder state at the end of every tail block
+    for (uint32_t i = 0; i < SERIES_STORE_MAX_SERIES; i++) {
+        series_store_series_t *series = &store->series[i];
+        if (series->used && series->tail != SERIES_STORE_NONE) {
+            series_store_iter_t it;
+            series_store_point_t point;
+
+            series_store_iter_init(&it, &store->blocks[series->tail]);
+            while (series_store_iter_next(&it, &point)) {
+            }
+            series->delta = it.delta;
+            series->bits = it.bits;
+            series->leading = it.leading;
+            series->trailing = it.trailing;
+        }
+    }
+}
+
+/**
+ * @brief Open or create the store file with room for block_count blocks
+ *
+ * A file written with another layout or size starts over empty.
+ */
+static inline bool series_store_open(series_store_t *store, const char *path, uint32_t block_count) {
+    memset(store, 0, sizeof(*store));
+    store->fd = -1;
+
+    if (block_count == 0) {
+        return false;
+    }
+
+    store->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (store->fd < 0) {
+        return false;
+    }
+
+    store->size = (size_t)(block_count + 1) * SERIES_STORE_BLOCK_SIZE;
+
+    struct stat st;
+    bool fresh = fstat(store->fd, &st) != 0 || (size_t)st.st_size != store->size;
+    if (fresh && (ftruncate(store->fd, 0) != 0 || ftruncate(store->fd, store->size) != 0)) {
+        close(store->fd);
+        store->fd = -1;
+        return false;
+    }
+
+    void *map = mmap(NULL, store->size, PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+    store->next = malloc(block_count * sizeof(uint32_t));
+    if (map == MAP_FAILED || !store->next) {
+        if (map != MAP_FAILED) {
+            munmap(map, store->size);
+        }
+        free(store->next);
+        close(store->fd);
+        store->fd = -1;
+        return false;
+    }
+
+    store->file = map;
+    store->blocks = (series_store_block_t *)((uint8_t *)map + SERIES_STORE_BLOCK_SIZE);
+    store->block_count = block_count;
+
+    if (store->file->magic != SERIES_STORE_MAGIC || store->file->version != SERIES_STORE_VERSION ||
+        store->file->block_size != SERIES_STORE_BLOCK_SIZE || store->file->blocks != block_count) {
+        memset(map, 0, store->size);
+        store->file->magic = SERIES_STORE_MAGIC;
+        store->file->version = SERIES_STORE_VERSION;
+        store->file->block_size = SERIES_STORE_BLOCK_SIZE;
+        store->file->blocks = block_count;
+    }
+
+    series_store_recover(store);
+    return true;
+}
+
+// Start writing the dirty pages back, without waiting for them
+static inline void series_store_sync(series_store_t *store) {
+    if (store->file) {
+        msync(store->file, store->size, MS_ASYNC);
+    }
+}
+
+static inline void series_store_close(series_store_t *store) {
+    if (store->file) {
+        msync(store->file, store->size, MS_SYNC);
+        munmap(store->file, store->size);
+    }
+    if (store->fd >= 0) {
+        close(store->fd);
+    }
+    free(store->next);
+    memset(store, 0, sizeof(*store));
+    store->fd = -1;
+}
+
+/* ========================================================================== */
+/*                                 QUERIES                                   */
+/* ========================================================================== */
+
+/**
+ * @brief Points of a series between from_ms and to_ms (inclusive), oldest first
+ * @return number of points copied to out, at most max
+ */
+static inline uint32_t series_store_range(const series_store_t *store, uint32_t key, int64_t from_ms, int64_t to_ms,
+                                   series_store_point_t *out, uint32_t max) {
+    const series_store_series_t *series = series_store_find((series_store_t *)store, key, false);
+    uint32_t copied = 0;
+
+    if (!series) {
+        return 0;
+    }
+
+    for (uint32_t index = series->head; index != SERIES_STORE_NONE && copied < max; index = store->next[index]) {
+        const series_store_block_t *block = &store->blocks[index];
+        series_store_iter_t it;
+        series_store_point_t point;
+
+        if (block->last_ts < from_ms) {
+            continue;
+        }
+        if (block->first_ts > to_ms) {
+            break;
+        }
+
+        series_store_iter_init(&it, block);
+        while (copied < max && series_store_iter_next(&it, &point)) {
+            if (point.timestamp_ms > to_ms) {
+                break;
+            }
+            if (point.timestamp_ms >= from_ms) {
+                out[copied++] = point;
+            }
+        }
+    }
+    return copied;
+}
+
+static inline void series_store_bucket_add(series_store_bucket_t *bucket, int64_t start_ms, double value) {
+    if (bucket->count == 0) {
+        bucket->start_ms = start_ms;
+        bucket->min = value;
+        bucket->max = value;
+        bucket->sum = 0.0;
+        bucket->first = value;
+    }
+    if (value < bucket->min) bucket->min = value;
+    if (value > bucket->max) bucket->max = value;
+    bucket->sum += value;
+    bucket->last = value;
+    bucket->count++;
+}
+
+/**
+ * @brief Series between from_ms and to_ms in buckets of bucket_ms from from_ms
+ *
+ * Blocks entirely within one bucket are taken from their header.
+ *
+ * @return number of non-empty buckets copied to out, oldest first, at most max
+ */
+static inline uint32_t series_store_downsample(const series_store_t *store, uint32_t key, int64_t from_ms, int64_t to_ms,
+                                        int64_t bucket_ms, series_store_bucket_t *out, uint32_t max) {
+    const series_store_series_t *series = series_store_find((series_store_t *)store, key, false);
+    series_store_bucket_t bucket = { 0 };
+    int64_t current = -1;
+    uint32_t copied = 0;
+
+    if (!series || bucket_ms <= 0 || max == 0) {
+        return 0;
+    }
+
+    for (uint32_t index = series->head; index != SERIES_STORE_NONE; index = store->next[index]) {
+        const series_store_block_t *block = &store->blocks[index];
+
+        if (block->last_ts < from_ms) {
+            continue;
+        }
+        if (block->first_ts > to_ms) {
+            break;
+        }
+
+        int64_t first = (block->first_ts - from_ms) / bucket_ms;
+        int64_t last = (block->last_ts - from_ms) / bucket_ms;
+
+        if (block->first_ts >= from_ms && block->last_ts <= to_ms && first == last) {
+            if (first != current && bucket.count) {
+                out[copied++] = bucket;
+                bucket.count = 0;
+                if (copied == max) {
+                    return copied;
+                }
+            }
+            current = first;
+            if (bucket.count == 0) {
+                bucket.start_ms = from_ms + first * bucket_ms;
+                bucket.min = block->min;
+                bucket.max = block->max;
+                bucket.sum = 0.0;
+                bucket.first = block->first_value;
+            }
+            if (block->min < bucket.min) bucket.min = block->min;
+            if (block->max > bucket.max) bucket.max = block->max;
+            bucket.sum += block->sum;
+            bucket.last = block->last_value;
+            bucket.count += block->count;
+            continue;
+        }
+
+        series_store_iter_t it;
+        series_store_point_t point;
+
+        series_store_iter_init(&it, block);
+        while (series_store_iter_next(&it, &point)) {
+            if (point.timestamp_ms > to_ms) {
+                break;
+            }
+            if (point.timestamp_ms < from_ms) {
+                continue;
+            }
+
+            int64_t n = (point.timestamp_ms - from_ms) / bucket_ms;
+            if (n != current && bucket.count) {
+                out[copied++] = bucket;
+                bucket.count = 0;
+                if (copied == max) {
+                    return copied;
+                }
+            }
+            current = n;
+            series_store_bucket_add(&bucket, from_ms + n * bucket_ms, point.value);
+        }
+    }
+
+    if (bucket.count) {
+        out[copied++] = bucket;
+    }
+    return copied;
+}
+
+/**
+ * @brief Oldest timestamp and bytes used by a series
+ * @return false for an unknown or empty series
+ */
+static inline bool series_store_info(const series_store_t *store, uint32_t key, int64_t *oldest_ms, uint64_t *bytes) {
+    const series_store_series_t *series = series_store_find((series_store_t *)store, key, false);
+
+    if (!series || series->head == SERIES_STORE_NONE) {
+        return false;
+    }
+
+    *oldest_ms = store->blocks[series->head].first_ts;
+    *bytes = 0;
+    for (uint32_t index = series->head; index != SERIES_STORE_NONE; index = store->next[index]) {
+        const series_store_block_t *block = &store->blocks[index];
+        *bytes += SERIES_STORE_HEADER_SIZE + (block->ts_bits + 7) / 8 + (block->value_bits + 7) / 8;
+    }
+    return true;
+}
+
+#endif // SERIES_STORE_H
@@ -0,0 +1,383 @@
+/**
+ * @file CAN_busload.h
+ * @brief Bit accurate CAN bus load estimation per priority class
+ * @version 1.0
+ * @date 2026
+ *
+ * Every received frame is measured with its on-wire length, SOF up to and
+ * including the intermission:
+ *
+ *   classic   SFF 47 + 8 * len bits, EFF 67 + 8 * len, RTR frames without data
+ *   CAN FD    SOF..BRS (17 SFF, 36 EFF) and CRC delimiter..IFS (13) at the
+ *             nominal rate, ESI, DLC, data, stuff count and CRC (17 up to 16
+ *             bytes, 21 above) with their fixed stuff bits at the data rate
+ *             if BRS is set
+ *
+ * plus the dynamic stuff bits between SOF and the end of the CRC (classic) or
+ * the data field (FD), counted exactly by a table driven stuffing state
+ * machine (after a byte wise CRC-15 for classic frames). The worst case is
+ * kept alongside from a table per length.
+ *
+ * Utilisation is kept over a sliding window of CAN_BUSLOAD_BUCKETS buckets of
+ * 2^CAN_BUSLOAD_BUCKET_SHIFT ns, per priority class of the extended ID layout
+ * in CAN_bus.h. Adding a frame needs no division, only can_busload_init() and
+ * can_busload_read() divide.
+ *
+ * Same calculation as the bus load of the socketcan addon's capture
+ * (Node-APPS/Application_CANbus/node_modules/socketcan/native/busload.cc).
+ */
+
+#ifndef CAN_BUSLOAD_H
+#define CAN_BUSLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <linux/can.h>
+
+/* ========================================================================== */
+/*                              CONFIGURATION                                */
+/* ========================================================================== */
+
+// Define before including to change the window, default 16 x 67.1 ms
+#ifndef CAN_BUSLOAD_BUCKET_SHIFT
+#define CAN_BUSLOAD_BUCKET_SHIFT    26      // bucket width 2^26 ns
+#endif
+#ifndef CAN_BUSLOAD_BUCKETS
+#define CAN_BUSLOAD_BUCKETS         16      // power of two
+#endif
+
+// Priority classes of the extended ID layout (see PRIORITY_* in CAN_bus.h)
+#define CAN_BUSLOAD_CLASS_EMERGENCY     0   // priority 0-3
+#define CAN_BUSLOAD_CLASS_HIGH          1   // 4-7
+#define CAN_BUSLOAD_CLASS_NORMAL        2   // 8-15
+#define CAN_BUSLOAD_CLASS_LOW           3   // 16-23
+#define CAN_BUSLOAD_CLASS_BACKGROUND    4   // 24-31
+#define CAN_BUSLOAD_CLASS_STANDARD      5   // 11 bit IDs, outside the layout
+#define CAN_BUSLOAD_CLASSES             6
+
+// Frame flags: CANFD_BRS and CANFD_ESI as in a canfd_frame, plus
+#define CAN_BUSLOAD_FD                  0x80
+
+/* ========================================================================== */
+/*                                  TYPES                                    */
+/* ========================================================================== */
+
+typedef struct {
+    uint32_t nominal;               // bits at the arbitration rate, including stuff bits
+    uint32_t data;                  // bits at the data rate (CAN FD with BRS only)
+    uint32_t worst_nominal;         // same with worst case stuffing
+    uint32_t worst_data;
+} can_busload_bits_t;
+
+typedef struct {
+    double total;                   // percent with the actual stuff bits
+    double worst;                   // percent with worst case stuffing
+    double classes[CAN_BUSLOAD_CLASSES];
+} can_busload_t;
+
+typedef struct {
+    uint32_t bitrate;
+    uint32_t dbitrate;
+    uint32_t nominal_ps;            // ps per bit
+    uint32_t data_ps;
+    uint64_t frames;
+    struct {
+        uint64_t epoch;             // timestamp >> CAN_BUSLOAD_BUCKET_SHIFT
+        uint64_t ps[CAN_BUSLOAD_CLASSES];
+        uint64_t worst;
+    } buckets[CAN_BUSLOAD_BUCKETS];
+} can_busload_meter_t;
+
+/* ========================================================================== */
+/*                              LOOKUP TABLES                                */
+/* ========================================================================== */
+
+#define CAN_BUSLOAD_CRC15_POLY      0x4599
+#define CAN_BUSLOAD_STUFF_IDLE      4       // recessive bus, SOF starts a new run
+
+typedef struct {
+    uint16_t nominal;               // fixed bits
+    uint16_t data;
+    uint16_t worst_nominal;         // worst case stuff bits
+    uint16_t worst_data;
+} can_busload_layout_t;
+
+static bool can_busload_tables_ready = false;
+static uint8_t can_busload_stuff_table[8][256];     // stuff bits << 3 | next state
+static uint16_t can_busload_crc15_table[256];
+static uint8_t can_busload_fd_dlc[CANFD_MAX_DLEN + 1];
+static can_busload_layout_t can_busload_classic[2][CAN_MAX_DLEN + 1];   // [ext][len]
+static can_busload_layout_t can_busload_fd[2][CANFD_MAX_DLEN + 1];      // [ext][len]
+static uint8_t can_busload_class[32];
+
+// Stuffing state: last bit << 2 | (run length - 1)
+static inline uint32_t can_busload_stuff_step(uint32_t state, uint32_t bit, uint32_t *count) {
+    uint32_t last = state >> 2;
+
+    if (bit != last) {
+        return bit << 2;
+    }
+    if ((state & 3) < 3) {
+        return state + 1;
+    }
+
+    // Fifth equal bit, the inserted complement starts the next run
+    (*count)++;
+    return (last ^ 1) << 2;
+}
+
+static void can_busload_init_tables(void) {
+    if (can_busload_tables_ready) {
+        return;
+    }
+
+    for (uint32_t state = 0; state < 8; state++) {
+        for (uint32_t value = 0; value < 256; value++) {
+            uint32_t count = 0;
+            uint32_t next = state;
+            for (int bit = 7; bit >= 0; bit--) {
+                next = can_busload_stuff_step(next, (value >> bit) & 1, &count);
+            }
+            can_busload_stuff_table[state][value] = (uint8_t)(count << 3 | next);
+        }
+    }
+
+    for (uint32_t value = 0; value < 256; value++) {
+        uint32_t crc = value << 7;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x4000) ? ((crc << 1) ^ CAN_BUSLOAD_CRC15_POLY) : (crc << 1);
+        }
+        can_busload_crc15_table[value] = crc & 0x7FFF;
+    }
+
+    for (uint32_t len = 0; len <= CANFD_MAX_DLEN; len++) {
+        can_busload_fd_dlc[len] = len <= 8 ? len : len <= 12 ? 9 : len <= 16 ? 10 : len <= 20 ? 11
+                                : len <= 24 ? 12 : len <= 32 ? 13 : len <= 48 ? 14 : 15;
+    }
+
+    for (uint32_t ext = 0; ext < 2; ext++) {
+        for (uint32_t len = 0; len <= CAN_MAX_DLEN; len++) {
+            can_busload_layout_t *layout = &can_busload_classic[ext][len];
+            uint32_t stuffed = (ext ? 54 : 34) + 8 * len;       // SOF..CRC
+
+            layout->nominal = (ext ? 67 : 47) + 8 * len;
+            layout->data = 0;
+            layout->worst_nominal = (stuffed - 1) / 4;
+            layout->worst_data = 0;
+        }
+
+        for (uint32_t len = 0; len <= CANFD_MAX_DLEN; len++) {
+            can_busload_layout_t *layout = &can_busload_fd[ext][len];
+            uint32_t arbitration = ext ? 36 : 17;               // SOF..BRS
+            uint32_t stuffed = arbitration + 5 + 8 * len;       // SOF..data
+
+            layout->nominal = arbitration + 13;
+            layout->data = 5 + 8 * len + (len <= 16 ? 27 : 32);
+            layout->worst_nominal = (arbitration - 1) / 4;
+            layout->worst_data = (stuffed - 1) / 4 - layout->worst_nominal;
+        }
+    }
+
+    for (uint32_t priority = 0; priority < 32; priority++) {
+        can_busload_class[priority] = priority < 4 ? CAN_BUSLOAD_CLASS_EMERGENCY
+                                    : priority < 8 ? CAN_BUSLOAD_CLASS_HIGH
+                                    : priority < 16 ? CAN_BUSLOAD_CLASS_NORMAL
+                                    : priority < 24 ? CAN_BUSLOAD_CLASS_LOW
+                                    : CAN_BUSLOAD_CLASS_BACKGROUND;
+    }
+
+    can_busload_tables_ready = true;
+}
+
+// Stuff bits of the lowest nbits of value, MSB first
+static inline uint32_t can_busload_stuff_bits(uint32_t *state, uint64_t value, int nbits) {
+    uint32_t count = 0;
+
+    while (nbits & 7) {
+        nbits--;
+        *state = can_busload_stuff_step(*state, (value >> nbits) & 1, &count);
+    }
+    while (nbits > 0) {
+        nbits -= 8;
+        uint8_t entry = can_busload_stuff_table[*state][(value >> nbits) & 0xFF];
+        count += entry >> 3;
+        *state = entry & 7;
+    }
+    return count;
+}
+
+static inline uint32_t can_busload_stuff_bytes(uint32_t *state, const uint8_t *data, uint32_t len) {
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t entry = can_busload_stuff_table[*state][data[i]];
+        count += entry >> 3;
+        *state = entry & 7;
+    }
+    return count;
+}
+
+static inline uint32_t can_busload_crc15_byte(uint32_t crc, uint8_t value) {
+    return ((crc << 8) ^ can_busload_crc15_table[((crc >> 7) ^ value) & 0xFF]) & 0x7FFF;
+}
+
+/* ========================================================================== */
+/*                                FUNCTIONS                                  */
+/* ========================================================================== */
+
+/**
+ * @brief Priority class of a CAN ID (with CAN_EFF_FLAG for extended IDs)
+ */
+static inline int can_busload_priority_class(uint32_t can_id) {
+    return (can_id & CAN_EFF_FLAG) ? can_busload_class[(can_id >> 24) & 0x1F] : CAN_BUSLOAD_CLASS_STANDARD;
+}
+
+/**
+ * @brief On-wire bits of a frame with the actual and the worst case stuff bits
+ * @param flags CAN_BUSLOAD_FD, CANFD_BRS, CANFD_ESI
+ */
+static void can_busload_frame_bits(uint32_t can_id, const uint8_t *data, uint8_t len, uint8_t flags,
+                                   can_busload_bits_t *bits) {
+    uint32_t ext = (can_id & CAN_EFF_FLAG) ? 1 : 0;
+    uint32_t id = can_id & (ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+    uint32_t state = CAN_BUSLOAD_STUFF_IDLE;
+
+    if (flags & CAN_BUSLOAD_FD) {
+        uint32_t n = len > CANFD_MAX_DLEN ? CANFD_MAX_DLEN : len;
+        uint32_t brs = (flags & CANFD_BRS) ? 1 : 0;
+        uint32_t esi = (flags & CANFD_ESI) ? 1 : 0;
+        const can_busload_layout_t *layout = &can_busload_fd[ext][n];
+
+        // SOF, ID (SRR, IDE), RRS, FDF, res, BRS
+        uint32_t arbitration = ext
+            ? can_busload_stuff_bits(&state, (uint64_t)(id >> 18) << 24 | 3 << 22 | (id & 0x3FFFF) << 4 | 4 | brs, 36)
+            : can_busload_stuff_bits(&state, id << 5 | 4 | brs, 17);
+
+        // ESI, DLC and data, the CRC field has fixed stuff bits only
+        uint32_t stuffed = can_busload_stuff_bits(&state, esi << 4 | can_busload_fd_dlc[n], 5)
+                         + can_busload_stuff_bytes(&state, data, n);
+
+        bits->nominal = layout->nominal + arbitration;
+        bits->data = layout->data + stuffed;
+        bits->worst_nominal = layout->nominal + layout->worst_nominal;
+        bits->worst_data = layout->data + layout->worst_data;
+
+        if (!brs) {
+            bits->nominal += bits->data;
+            bits->worst_nominal += bits->worst_data;
+            bits->data = 0;
+            bits->worst_data = 0;
+        }
+    } else {
+        uint32_t rtr = (can_id & CAN_RTR_FLAG) ? 1 : 0;
+        uint32_t dlc = len > CAN_MAX_DLEN ? CAN_MAX_DLEN : len;
+        uint32_t n = rtr ? 0 : dlc;
+        const can_busload_layout_t *layout = &can_busload_classic[ext][n];
+
+        // SOF, ID (SRR, IDE), RTR, IDE/r1, r0, DLC. SOF is dominant, so the
+        // leading zeros of the byte aligned header do not change the CRC.
+        uint64_t header = ext
+            ? (uint64_t)(id >> 18) << 27 | 3ULL << 25 | (uint64_t)(id & 0x3FFFF) << 7 | rtr << 6 | dlc
+            : id << 7 | rtr << 6 | dlc;
+        int header_bits = ext ? 39 : 19;
+
+        uint32_t crc = 0;
+        for (int shift = (header_bits + 7) & ~7; shift > 0; shift -= 8) {
+            crc = can_busload_crc15_byte(crc, (header >> (shift - 8)) & 0xFF);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            crc = can_busload_crc15_byte(crc, data[i]);
+        }
+
+        uint32_t stuffed = can_busload_stuff_bits(&state, header, header_bits)
+                         + can_busload_stuff_bytes(&state, data, n)
+                         + can_busload_stuff_bits(&state, crc, 15);
+
+        bits->nominal = layout->nominal + stuffed;
+        bits->data = 0;
+        bits->worst_nominal = layout->nominal + layout->worst_nominal;
+        bits->worst_data = 0;
+    }
+}
+
+/**
+ * @brief Reset the meter and set the bit rates
+ * @param dbitrate CAN FD data bit rate, 0 for the nominal rate
+ */
+static void can_busload_init(can_busload_meter_t *meter, uint32_t bitrate, uint32_t dbitrate) {
+    can_busload_init_tables();
+
+    memset(meter, 0, sizeof(*meter));
+    meter->bitrate = bitrate;
+    meter->dbitrate = dbitrate ? dbitrate : bitrate;
+    meter->nominal_ps = (uint32_t)((1000000000000ULL + meter->bitrate / 2) / meter->bitrate);
+    meter->data_ps = (uint32_t)((1000000000000ULL + meter->dbitrate / 2) / meter->dbitrate);
+}
+
+/**
+ * @brief Account a received frame, error frames are ignored
+ * @param timestamp_ns receive time, e.g. CLOCK_MONOTONIC
+ * @param flags CAN_BUSLOAD_FD, CANFD_BRS, CANFD_ESI
+ */
+static void can_busload_add(can_busload_meter_t *meter, uint64_t timestamp_ns, uint32_t can_id,
+                            const uint8_t *data, uint8_t len, uint8_t flags) {
+    if (can_id & CAN_ERR_FLAG) {
+        return;
+    }
+
+    can_busload_bits_t bits;
+    can_busload_frame_bits(can_id, data, len, flags, &bits);
+
+    uint64_t epoch = timestamp_ns >> CAN_BUSLOAD_BUCKET_SHIFT;
+    uint32_t slot = epoch & (CAN_BUSLOAD_BUCKETS - 1);
+
+    if (meter->buckets[slot].epoch != epoch) {
+        // Older than the window
+        if (epoch < meter->buckets[slot].epoch) {
+            return;
+        }
+        memset(&meter->buckets[slot], 0, sizeof(meter->buckets[slot]));
+        meter->buckets[slot].epoch = epoch;
+    }
+
+    meter->buckets[slot].ps[can_busload_priority_class(can_id)] +=
+        (uint64_t)bits.nominal * meter->nominal_ps + (uint64_t)bits.data * meter->data_ps;
+    meter->buckets[slot].worst +=
+        (uint64_t)bits.worst_nominal * meter->nominal_ps + (uint64_t)bits.worst_data * meter->data_ps;
+    meter->frames++;
+}
+
+/**
+ * @brief Utilisation in percent over the window ending at now_ns
+ */
+static void can_busload_read(const can_busload_meter_t *meter, uint64_t now_ns, can_busload_t *load) {
+    uint64_t epoch = now_ns >> CAN_BUSLOAD_BUCKET_SHIFT;
+    // Shorter window until CAN_BUSLOAD_BUCKETS buckets have passed since time 0
+    uint64_t oldest = epoch >= CAN_BUSLOAD_BUCKETS - 1 ? epoch - (CAN_BUSLOAD_BUCKETS - 1) : 0;
+    uint64_t sums[CAN_BUSLOAD_CLASSES] = { 0 };
+    uint64_t worst = 0;
+
+    for (int i = 0; i < CAN_BUSLOAD_BUCKETS; i++) {
+        if (meter->buckets[i].epoch < oldest || meter->buckets[i].epoch > epoch) {
+            continue;
+        }
+        for (int c = 0; c < CAN_BUSLOAD_CLASSES; c++) {
+            sums[c] += meter->buckets[i].ps[c];
+        }
+        worst += meter->buckets[i].worst;
+    }
+
+    // Window from the start of the oldest bucket until now, in ps
+    double scale = 100.0 / ((double)(now_ns - (oldest << CAN_BUSLOAD_BUCKET_SHIFT)) * 1000.0);
+
+    load->total = 0;
+    for (int c = 0; c < CAN_BUSLOAD_CLASSES; c++) {
+        load->classes[c] = sums[c] * scale;
+        load->total += load->classes[c];
+    }
+    load->worst = worst * scale;
+}
+
+#endif // CAN_BUSLOAD_H
@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <pigpio.h>
+#include <signal.h>
+#include <getopt.h>
+
+// Transmitter counterpart of RF_433_MHz_Application.c. Messages are encoded
+// the way the receiver decodes them and sent as pigpio DMA waveforms, so the
+// bit timing does not depend on scheduling. Repeated transmissions are queued
+// as a single wave chain to load-test the receiver back to back.
+//
+// Build: gcc -Wall -o RF_433_MHz_Transmitter RF_433_MHz_Transmitter.c -lpigpio -lrt -pthread
+
+// Configuration
+#define RF_TX_PIN 17                    // GPIO pin for RF 433MHz transmitter
+#define DEFAULT_BAUD_RATE 2000          // Default baud rate (must match receiver)
+#define MAX_MESSAGE_LEN 128             // Maximum message length
+#define DEFAULT_GAP_MS 20               // Idle time after each transmission
+#define BYTE_GAP_MS 10                  // Idle time between basic ASCII bytes
+#define MANCHESTER_PREAMBLE_BYTES 2     // 0xFF bytes, sent as repeated high-low
+
+// Protocol constants (matching RF_433_MHz_Application.c)
+#define RF_PREAMBLE_LENGTH 36           // 36 alternating bits
+#define RF_START_SYMBOL 0xB38           // 12-bit start symbol
+#define RF_START_SYMBOL_BITS 12
+
+// Longest waveform: a Manchester message with an edge every half bit
+#define MAX_WAVE_PULSES ((MANCHESTER_PREAMBLE_BYTES + MAX_MESSAGE_LEN + 1) * 16 + 1)
+
+// Transmission modes
+typedef enum {
+    MODE_BASIC_ASCII = 1,             // Basic ASCII transmission
+    MODE_STRUCTURED_PROTOCOL = 2,      // Protocol with preamble, start symbol and CRC
+    MODE_MANCHESTER_ENCODING = 3       // Manchester encoding for noise immunity
+} TransmitMode;
+
+// 4-to-6 bit encoding table. Symbols 0x0-0xB are the ones decode_6to4_table
+// in the receiver accepts, 0xC-0xF complete the code with the remaining
+// DC-balanced symbols. The receiver currently rejects those four.
+const uint8_t encode_4to6_table[16] = {
+    13, 14, 19, 21, 22, 25, 26, 28,
+    35, 37, 38, 62, 42, 44, 50, 52
+};
+
+// Waveform under construction for one GPIO
+typedef struct {
+    gpioPulse_t pulses[MAX_WAVE_PULSES];
+    int count;
+    int level;
+    uint32_t mask;
+    uint32_t bit_us;
+} WaveBuilder;
+
+// Global variables
+volatile bool running = true;
+bool verbose_mode = false;
+bool unsupported_symbols = false;
+
+// Signal handler for Ctrl+C and other termination signals
+void signal_handler(int sig) {
+    running = false;
+}
+
+// Calculate CRC-16 (CCITT variant) - same as in PIC32MX code
+uint16_t calculate_crc16(const uint8_t* data, uint8_t length) {
+    uint16_t crc = 0xFFFF; // Initial value
+
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            if (crc & 0x0001) {
+                crc >>= 1;
+                crc ^= 0xA001; // Polynomial 0x8005 (reversed)
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+void wave_init(WaveBuilder* wave, int tx_pin, int baud_rate) {
+    wave->count = 0;
+    wave->level = -1;
+    wave->mask = 1u << tx_pin;
+    wave->bit_us = 1000000 / baud_rate;
+}
+
+// Holds the line at a level. A level following the same level extends the
+// previous pulse, so the waveform only has one pulse per edge.
+void wave_level(WaveBuilder* wave, int level, uint32_t duration_us) {
+    if (duration_us == 0) {
+        return;
+    }
+
+    if (level == wave->level) {
+        wave->pulses[wave->count - 1].usDelay += duration_us;
+        return;
+    }
+
+    gpioPulse_t* pulse = &wave->pulses[wave->count++];
+    pulse->gpioOn = level ? wave->mask : 0;
+    pulse->gpioOff = level ? 0 : wave->mask;
+    pulse->usDelay = duration_us;
+    wave->level = level;
+}
+
+// Sends bits as plain NRZ levels, one bit time each
+void wave_bits_msb_first(WaveBuilder* wave, uint32_t value, int bits) {
+    for (int i = bits - 1; i >= 0; i--) {
+        wave_level(wave, (value >> i) & 0x01, wave->bit_us);
+    }
+}
+
+void wave_bits_lsb_first(WaveBuilder* wave, uint32_t value, int bits) {
+    for (int i = 0; i < bits; i++) {
+        wave_level(wave, (value >> i) & 0x01, wave->bit_us);
+    }
+}
+
+// Mirrors receive_byte(): 8 bits, least significant bit first
+void wave_byte(WaveBuilder* wave, uint8_t byte) {
+    wave_bits_lsb_first(wave, byte, 8);
+}
+
+// Mirrors receive_4to6_encoded_byte(): high nibble symbol, then low nibble
+// symbol, each 6 bits least significant bit first
+void wave_4to6_encoded_byte(WaveBuilder* wave, uint8_t byte) {
+    if ((byte >> 4) > 0x0B || (byte & 0x0F) > 0x0B) {
+        unsupported_symbols = true;
+    }
+    wave_bits_lsb_first(wave, encode_4to6_table[byte >> 4], 6);
+    wave_bits_lsb_first(wave, encode_4to6_table[byte & 0x0F], 6);
+}
+
+// Mirrors receive_manchester_byte(): 10 = 1, 01 = 0, least significant bit first
+void wave_manchester_byte(WaveBuilder* wave, uint8_t byte) {
+    uint32_t half_bit_us = wave->bit_us / 2;
+
+    for (int i = 0; i < 8; i++) {
+        int bit = (byte >> i) & 0x01;
+        wave_level(wave, bit, half_bit_us);
+        wave_level(wave, !bit, half_bit_us);
+    }
+}
+
+// Basic ASCII: the receiver starts a byte at the first high level it sees and
+// polls the line every 5 ms while it is low, so bytes are separated by idle
+// time. There is no start bit, bytes with a 0 least significant bit can only be
+// picked up by the receiver if a poll happens to fall on the first high bit.
+void build_basic_ascii_message(WaveBuilder* wave, const uint8_t* message, int length) {
+    for (int i = 0; i < length; i++) {
+        wave_byte(wave, message[i]);
+        wave_level(wave, 0, BYTE_GAP_MS * 1000);
+    }
+}
+
+// Structured protocol: preamble, start symbol, length, 4-to-6 encoded data
+// and CRC, in the order receive_structured_protocol_message() reads them
+void build_structured_protocol_message(WaveBuilder* wave, const uint8_t* message, int length) {
+    uint16_t crc = calculate_crc16(message, length);
+
+    // 1. Preamble of alternating bits
+    for (int i = 0; i < RF_PREAMBLE_LENGTH; i++) {
+        wave_level(wave, !(i & 0x01), wave->bit_us);
+    }
+
+    // 2. Start symbol, most significant bit first
+    wave_bits_msb_first(wave, RF_START_SYMBOL, RF_START_SYMBOL_BITS);
+
+    // 3. Length byte includes the two CRC bytes
+    wave_byte(wave, (uint8_t)(length + 2));
+
+    // 4. Data
+    for (int i = 0; i < length; i++) {
+        wave_4to6_encoded_byte(wave, message[i]);
+    }
+
+    // 5. CRC, low byte first
+    wave_4to6_encoded_byte(wave, crc & 0xFF);
+    wave_4to6_encoded_byte(wave, crc >> 8);
+}
+
+// Manchester: a preamble of 1 bits (repeated high-low) followed by the data and
+// a zero byte, which receive_manchester_message() takes as end of transmission
+void build_manchester_message(WaveBuilder* wave, const uint8_t* message, int length) {
+    for (int i = 0; i < MANCHESTER_PREAMBLE_BYTES; i++) {
+        wave_manchester_byte(wave, 0xFF);
+    }
+
+    for (int i = 0; i < length; i++) {
+        wave_manchester_byte(wave, message[i]);
+    }
+
+    wave_manchester_byte(wave, 0x00);
+}
+
+// Creates the DMA waveform for one transmission, including the idle gap after it
+int create_message_wave(WaveBuilder* wave, int mode, const uint8_t* message, int length, int gap_ms) {
+    switch (mode) {
+        case MODE_BASIC_ASCII:
+            build_basic_ascii_message(wave, message, length);
+            break;
+        case MODE_STRUCTURED_PROTOCOL:
+            build_structured_protocol_message(wave, message, length);
+            break;
+        case MODE_MANCHESTER_ENCODING:
+            build_manchester_message(wave, message, length);
+            break;
+        default:
+            return -1;
+    }
+
+    // Leave the transmitter off between transmissions
+    wave_level(wave, 0, gap_ms > 0 ? (uint32_t)gap_ms * 1000 : wave->bit_us);
+
+    gpioWaveClear();
+
+    if (gpioWaveAddGeneric(wave->count, wave->pulses) < 0) {
+        fprintf(stderr, "Failed to add %d pulses to the waveform\n", wave->count);
+        return -1;
+    }
+
+    int wave_id = gpioWaveCreate();
+    if (wave_id < 0) {
+        fprintf(stderr, "Failed to create waveform (%d)\n", wave_id);
+        return -1;
+    }
+
+    return wave_id;
+}
+
+// Sends the wave repeat_count times back to back, or until stopped if
+// repeat_count is 0. Repeats are looped by the DMA engine, so there are no
+// gaps between transmissions other than the one in the waveform.
+int transmit_repeated(int wave_id, int repeat_count) {
+    char chain[16];
+    int length = 0;
+
+    chain[length++] = 255; // Loop start
+    chain[length++] = 0;
+    chain[length++] = wave_id;
+
+    if (repeat_count == 0) {
+        chain[length++] = 255; // Loop forever
+        chain[length++] = 3;
+    } else {
+        chain[length++] = 255; // Loop repeat_count times
+        chain[length++] = 1;
+        chain[length++] = repeat_count & 0xFF;
+        chain[length++] = (repeat_count >> 8) & 0xFF;
+    }
+
+    int result = gpioWaveChain(chain, length);
+    if (result < 0) {
+        fprintf(stderr, "Failed to transmit wave chain (%d)\n", result);
+        return -1;
+    }
+
+    while (running && gpioWaveTxBusy()) {
+        gpioDelay(10000);
+    }
+
+    if (gpioWaveTxBusy()) {
+        gpioWaveTxStop();
+    }
+
+    return 0;
+}
+
+// Print usage instructions
+void print_usage(char* program_name) {
+    printf("Usage: %s [options] [message]\n", program_name);
+    printf("Options:\n");
+    printf("  -p PIN    : GPIO pin number for RF transmitter (default: %d)\n", RF_TX_PIN);
+    printf("  -b BAUD   : Baud rate (default: %d)\n", DEFAULT_BAUD_RATE);
+    printf("  -m MODE   : Transmission mode (1=Basic, 2=Structured, 3=Manchester)\n");
+    printf("  -r COUNT  : Number of back to back transmissions, 0 = until Ctrl+C (default: 1)\n");
+    printf("  -g MS     : Idle time after each transmission in ms (default: %d)\n", DEFAULT_GAP_MS);
+    printf("  -v        : Verbose output\n");
+    printf("  -h        : Show this help\n");
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    int tx_pin = RF_TX_PIN;
+    int baud_rate = DEFAULT_BAUD_RATE;
+    int mode = MODE_STRUCTURED_PROTOCOL;
+    int repeat_count = 1;
+    int gap_ms = DEFAULT_GAP_MS;
+    int opt;
+
+    // Parse command line arguments
+    while ((opt = getopt(argc, argv, "p:b:m:r:g:vh")) != -1) {
+        switch (opt) {
+            case 'p':
+                tx_pin = atoi(optarg);
+                break;
+            case 'b':
+                baud_rate = atoi(optarg);
+                break;
+            case 'm':
+                mode = atoi(optarg);
+                break;
+            case 'r':
+                repeat_count = atoi(optarg);
+                break;
+            case 'g':
+                gap_ms = atoi(optarg);
+                break;
+            case 'v':
+                verbose_mode = true;
+                break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    const char* text = optind < argc ? argv[optind] : "Hello World";
+    int length = strlen(text);
+
+    if (tx_pin < 0 || tx_pin > 31 || baud_rate <= 0 || baud_rate > 100000 ||
+        mode < MODE_BASIC_ASCII || mode > MODE_MANCHESTER_ENCODING ||
+        repeat_count < 0 || repeat_count > 65535 || gap_ms < 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (length == 0 || length > MAX_MESSAGE_LEN - 2) {
+        fprintf(stderr, "Message must be 1 to %d bytes\n", MAX_MESSAGE_LEN - 2);
+        return EXIT_FAILURE;
+    }
+
+    printf("RF 433MHz Transmitter (Raspberry Pi)\n");
+    printf("------------------------------------\n");
+    printf("RF Transmitter Pin: GPIO %d\n", tx_pin);
+    printf("Baud Rate: %d bps\n", baud_rate);
+    printf("Mode: %s\n",
+           mode == 1 ? "Basic ASCII" :
+           mode == 2 ? "Structured Protocol" : "Manchester Encoding");
+    printf("Message: '%s' (%d bytes)\n", text, length);
+    if (repeat_count == 0) {
+        printf("Repeat: until Ctrl+C\n\n");
+    } else {
+        printf("Repeat: %d\n\n", repeat_count);
+    }
+
+    // Initialize pigpio
+    if (gpioInitialise() < 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return EXIT_FAILURE;
+    }
+
+    // Set up signal handler for Ctrl+C
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    // Set up the RF transmitter pin, idle low
+    gpioSetMode(tx_pin, PI_OUTPUT);
+    gpioWrite(tx_pin, 0);
+
+    static WaveBuilder wave;
+    wave_init(&wave, tx_pin, baud_rate);
+
+    int wave_id = create_message_wave(&wave, mode, (const uint8_t*)text, length, gap_ms);
+    if (wave_id < 0) {
+        gpioTerminate();
+        return EXIT_FAILURE;
+    }
+
+    if (unsupported_symbols) {
+        printf("Warning: message or CRC contains nibbles 0xC-0xF, which the receiver cannot decode yet\n");
+    }
+
+    if (verbose_mode) {
+        printf("Waveform: %d pulses, %d us, %d DMA control blocks\n",
+               wave.count, gpioWaveGetMicros(), gpioWaveGetCbs());
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int result = transmit_repeated(wave_id, repeat_count);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (result == 0 && repeat_count > 0 && seconds > 0) {
+        printf("Sent %d transmissions in %.3f s (%.1f messages/s, %.0f payload bytes/s)\n",
+               repeat_count, seconds, repeat_count / seconds, repeat_count * length / seconds);
+    }
+
+    // Cleanup
+    gpioWaveDelete(wave_id);
+    gpioWrite(tx_pin, 0);
+    gpioTerminate();
+    printf("\nGoodbye!\n");
+    return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,6 +4,7 @@ const socketIo = require('socket.io');
 const can = require('socketcan');
 const fs = require('fs');
 const path = require('path');
+const { spawn } = require('child_process');
 
 // Create Express app
 const app = express();
@@ -18,6 +19,25 @@ app.use(express.json());
 const CAN_INTERFACE = "can0";
 const PORT = 3020;
 const LOG_DIRECTORY = path.join(__dirname, 'logs');
+const LOG_SEGMENT_SIZE = 64 * 1024 * 1024;
+const LOG_EXTENSIONS = ['.canlog', '.csv'];
+
+// Packed frames delivered by the capture
+const CAPTURE_RECORD_SIZE = 80;
+const CAPTURE_FLAG_TX = 0x08;
+
+// Spacing of replayed messages at speed 1
+const REPLAY_INTERVAL_MS = 100;
+
+// Rate of the per ID live table sent to the clients, independent of the bus rate
+const LIVE_INTERVAL_MS = 100;
+
+// Offline converter for the binary log segments
+const CANLOG_TOOL = path.join(path.dirname(require.resolve('socketcan/package.json')), 'build', 'Release', 'canlog');
+
+function isLogFile(fileName) {
+  return LOG_EXTENSIONS.includes(path.extname(fileName));
+}
 
 // Ensure log directory exists
 if (!fs.existsSync(LOG_DIRECTORY)) {
@@ -26,10 +46,30 @@ if (!fs.existsSync(LOG_DIRECTORY)) {
 
 // Initialize CAN channel
 let canChannel;
+let captureChannel;
+let aggregator;
 try {
-  // Create a raw channel using the proper method
+  // Create a raw channel using the proper method, only used for sending
   canChannel = can.createRawChannel(CAN_INTERFACE, true);
+
+  // Receiving, logging and pattern matching run natively on their own socket
+  // and threads, only matched frames reach JS
+  captureChannel = can.createCaptureChannel([CAN_INTERFACE]);
+  
+  // Latest frame, count and rate per ID, fed on the capture's merge thread
+  aggregator = can.createFrameAggregator();
+  captureChannel.setAggregator(aggregator);
   console.log(`Successfully connected to ${CAN_INTERFACE}`);
+  
+  // Bit rates for the bus load, virtual interfaces have none and keep the default
+  try {
+    const link = require('socketcan/build/Release/can_netlink.node').getLink(CAN_INTERFACE);
+    if (link.bittiming) {
+      captureChannel.setBitrate(CAN_INTERFACE, link.bittiming.bitrate, link.dataBittiming ? link.dataBittiming.bitrate : 0);
+    }
+  } catch (error) {
+    console.warn(`Bit rate of ${CAN_INTERFACE} unknown, bus load assumes 500 kbit/s:`, error.message);
+  }
 } catch (error) {
   console.error(`Failed to bind to ${CAN_INTERFACE}:`, error);
   process.exit(1);
@@ -47,9 +87,27 @@ function getFormattedDate() {
   return `${now.getFullYear()}-${String(now.getMonth() + 1).padStart(2, '0')}-${String(now.getDate()).padStart(2, '0')}`;
 }
 
-// Message cache for replay functionality
-let messageCache = [];
+// Message cache for replay functionality, a ring of the last MAX_CACHE_SIZE messages
 const MAX_CACHE_SIZE = 1000;
+const messageCache = new Array(MAX_CACHE_SIZE);
+let messageCacheNext = 0;
+let messageCacheCount = 0;
+
+function cacheMessage(logMessage) {
+  messageCache[messageCacheNext] = logMessage;
+  messageCacheNext = (messageCacheNext + 1) % MAX_CACHE_SIZE;
+  if (messageCacheCount < MAX_CACHE_SIZE) messageCacheCount++;
+}
+
+// Last count cached messages, oldest first
+function recentMessages(count) {
+  const result = [];
+  count = Math.min(count, messageCacheCount);
+  for (let i = count; i > 0; i--) {
+    result.push(messageCache[(messageCacheNext - i + MAX_CACHE_SIZE) % MAX_CACHE_SIZE]);
+  }
+  return result;
+}
 
 // Store known message patterns
 let knownPatterns = {};
@@ -62,30 +120,73 @@ try {
   knownPatterns = {};
 }
 
+// Frames of interest to analyzeCanMessage(), the saved patterns are appended
+const ANALYSIS_PATTERNS = [
+  { id: 0x7DF },                                      // OBD-II request
+  { id: 0x7E8, mask: 0x7FC },                         // OBD-II responses of ECU #1-#4
+  { id: 0x123 },                                      // Standard test message
+  { id: 0x100 },                                      // Sensor data
+  { id: 0x10000000, mask: 0x10000000, ext: true },    // J1939 (ID > 0x0FFF0000)
+  { id: 0x0FFF0000, mask: 0x1FFF0000, ext: true }
+];
+
+// Time allowed on top of the recorded delays for a saved sequence to be detected
+const PATTERN_SLACK_MS = 100;
+
+// Pattern names by matcher index behind ANALYSIS_PATTERNS
+let patternNames = [];
+
+// Compile the analysis rules and saved patterns into the native matcher of the capture
+function compilePatterns() {
+  const patterns = ANALYSIS_PATTERNS.slice();
+  const names = [];
+
+  Object.values(knownPatterns).forEach((pattern) => {
+    if (!Array.isArray(pattern.messages) || pattern.messages.length === 0) return;
+
+    const within = (pattern.delays || []).reduce((sum, delay) => sum + (Number(delay) || 0), 0);
+
+    patterns.push({
+      sequence: pattern.messages.map((msg) => ({
+        id: parseInt(msg.id, 16),
+        ext: !!msg.extended,
+        length: msg.data.length,
+        data: msg.data
+      })),
+      within: within + PATTERN_SLACK_MS
+    });
+    names.push(pattern.name);
+  });
+
+  try {
+    captureChannel.setMatcher(can.createPatternMatcher(patterns));
+    patternNames = names;
+  } catch (error) {
+    console.error(`[${getTimestamp()}] Error compiling patterns:`, error);
+  }
+}
+
 // Statistics
 let stats = {
   messagesSent: 0,
   messagesReceived: 0,
   startTime: Date.now(),
   busLoad: 0,
+  busLoadWorst: 0,
+  busLoadClasses: {},
   errorFrames: 0,
   peakLoad: 0
 };
 
 // Current logging state
 let loggingActive = false;
-let logStream = null;
 let logFileName = '';
 
-// Start logging to file
+// Start logging to binary segments, rotated every LOG_SEGMENT_SIZE bytes
 function startLogging() {
-  if (loggingActive) return;
-  
-  const timestamp = new Date().toISOString().replace(/[:.]/g, '-');
-  logFileName = path.join(LOG_DIRECTORY, `can-log-${timestamp}.csv`);
+  if (loggingActive) return logFileName;
   
-  logStream = fs.createWriteStream(logFileName);
-  logStream.write('Timestamp,Direction,ID,DLC,Data,Hex,ASCII,Analysis\n');
+  logFileName = captureChannel.startLog(LOG_DIRECTORY, { prefix: 'can-log', segment_size: LOG_SEGMENT_SIZE });
   loggingActive = true;
   
   return logFileName;
@@ -95,34 +196,64 @@ function startLogging() {
 function stopLogging() {
   if (!loggingActive) return null;
   
-  logStream.end();
-  logStream = null;
+  const log = captureChannel.stopLog();
   loggingActive = false;
   
-  return logFileName;
-}
-
-// Log message to file
-function logMessageToFile(message) {
-  if (!loggingActive || !logStream) return;
-  
-  const analysis = message.analysis ? JSON.stringify(message.analysis).replace(/,/g, ';') : 'N/A';
-  const line = `${message.timestamp},${message.direction},${message.id},${message.data.length},"${message.hex}","${message.ascii}",${analysis}\n`;
+  if (log.error) {
+    console.error(`[${getTimestamp()}] Logging failed:`, log.error);
+  }
   
-  logStream.write(line);
+  return logFileName;
 }
 
-// Bus utilization calculation (simplified)
-let messageCountInLastSecond = 0;
+// Bus utilization over the last second, frames are counted and measured bit by bit by the capture
 setInterval(() => {
-  stats.busLoad = messageCountInLastSecond / 10; // Simplified calculation, real CAN bus max ~1000 msgs/sec
+  const capture = captureChannel.stats();
+  const iface = capture.interfaces[0];
+  stats.messagesReceived = capture.merged;
+  stats.busLoad = iface.busLoad;
+  stats.busLoadWorst = iface.busLoadWorst;
+  stats.busLoadClasses = iface.busLoadClasses;
   if (stats.busLoad > stats.peakLoad) {
     stats.peakLoad = stats.busLoad;
   }
-  messageCountInLastSecond = 0;
   io.emit('stats', stats);
 }, 1000);
 
+// Send frames with their delays from the native TX scheduler, paced on its own
+// thread. The sent frames are logged as the progress events come in.
+function playSequence(socket, frames, options, toLogMessage) {
+  if (frames.length === 0) return;
+  
+  const scheduler = can.createTxScheduler(CAN_INTERFACE);
+  let logged = 0;
+  
+  const logProgress = (status) => {
+    for (; logged < status.index; logged++) {
+      stats.messagesSent++;
+      
+      // Add to message cache
+      const logMessage = toLogMessage(frames[logged], logged);
+      cacheMessage(logMessage);
+      
+      // Broadcast the sent message to all clients
+      io.emit('can-message', logMessage);
+    }
+    io.emit('stats', stats);
+  };
+  
+  scheduler.addListener('onProgress', logProgress);
+  scheduler.addListener('onDone', (status) => {
+    logProgress(status);
+    if (status.error) {
+      console.error(`[${getTimestamp()}] Error sending sequence: ${status.error}`);
+      socket.emit('error', { message: 'Failed to send sequence: ' + status.error });
+    }
+  });
+  
+  scheduler.play(can.encodeTxSequence(frames), frames.length, options);
+}
+
 // Socket.IO connection handling
 io.on('connection', (socket) => {
   console.log(`[${getTimestamp()}] Client connected`);
@@ -132,6 +263,9 @@ io.on('connection', (socket) => {
   socket.emit('logging-status', { active: loggingActive, fileName: logFileName });
   socket.emit('known-patterns', Object.keys(knownPatterns));
   
+  // Complete live table once, then the diffs broadcast every LIVE_INTERVAL_MS
+  socket.emit('live', aggregator.snapshot(true));
+  
   // Handle CAN message transmission requests from client
   socket.on('send-can-message', (message) => {
     try {
@@ -156,13 +290,7 @@ io.on('connection', (socket) => {
       };
       
       // Add to message cache
-      messageCache.push(logMessage);
-      if (messageCache.length > MAX_CACHE_SIZE) {
-        messageCache.shift();
-      }
-      
-      // Log to file if active
-      logMessageToFile(logMessage);
+      cacheMessage(logMessage);
       
       // Broadcast the sent message to all clients
       io.emit('can-message', logMessage);
@@ -177,48 +305,25 @@ io.on('connection', (socket) => {
   // Handle sequence transmission
   socket.on('send-sequence', (sequence) => {
     try {
-      let delayCounter = 0;
+      const frames = sequence.messages.map((msg, index) => ({
+        id: parseInt(msg.id, 16),
+        ext: msg.extended || false,
+        data: Buffer.from(msg.data),
+        delay: sequence.delays[index] || 0
+      }));
       
-      sequence.messages.forEach((msg, index) => {
-        delayCounter += sequence.delays[index] || 0;
-        
-        setTimeout(() => {
-          const canMessage = {
-            id: parseInt(msg.id, 16),
-            data: Buffer.from(msg.data),
-            ext: msg.extended || false
-          };
-          
-          canChannel.send(canMessage);
-          stats.messagesSent++;
-          
-          // Log the sent message
-          const logMessage = {
-            timestamp: getTimestamp(),
-            direction: 'TX',
-            id: '0x' + canMessage.id.toString(16).toUpperCase().padStart(3, '0'),
-            data: msg.data,
-            hex: [...Buffer.from(msg.data)].map(b => b.toString(16).toUpperCase().padStart(2, '0')).join(' '),
-            ascii: [...Buffer.from(msg.data)].map(b => (b >= 32 && b <= 126) ? String.fromCharCode(b) : '.').join(''),
-            decimal: [...Buffer.from(msg.data)].map(b => b.toString().padStart(3, ' ')).join(' ')
-          };
-          
-          // Add to message cache
-          messageCache.push(logMessage);
-          if (messageCache.length > MAX_CACHE_SIZE) {
-            messageCache.shift();
-          }
-          
-          // Log to file if active
-          logMessageToFile(logMessage);
-          
-          // Broadcast the sent message to all clients
-          io.emit('can-message', logMessage);
-          io.emit('stats', stats);
-        }, delayCounter);
-      });
+      // delays[0] is the wait before the first message
+      playSequence(socket, frames, { delay: frames.length ? frames[0].delay : 0 }, (frame, index) => ({
+        timestamp: getTimestamp(),
+        direction: 'TX',
+        id: '0x' + frame.id.toString(16).toUpperCase().padStart(3, '0'),
+        data: sequence.messages[index].data,
+        hex: [...frame.data].map(b => b.toString(16).toUpperCase().padStart(2, '0')).join(' '),
+        ascii: [...frame.data].map(b => (b >= 32 && b <= 126) ? String.fromCharCode(b) : '.').join(''),
+        decimal: [...frame.data].map(b => b.toString().padStart(3, ' ')).join(' ')
+      }));
       
-      socket.emit('sequence-started', { count: sequence.messages.length });
+      socket.emit('sequence-started', { count: frames.length });
     } catch (error) {
       console.error(`[${getTimestamp()}] Error sending sequence:`, error);
       socket.emit('error', { message: 'Failed to send sequence: ' + error.message });
@@ -229,46 +334,34 @@ io.on('connection', (socket) => {
   socket.on('replay-messages', (options) => {
     try {
       const { count, speed } = options;
-      const messagesToReplay = messageCache.slice(-count);
+      const messagesToReplay = recentMessages(count);
       const speedFactor = speed || 1;
+      const replayed = [];
+      const frames = [];
+      let previous = 0;
       
       socket.emit('replay-started', { count: messagesToReplay.length });
       
       messagesToReplay.forEach((msg, index) => {
-        setTimeout(() => {
-          // Skip if it's not a TX message (we only replay what was sent before)
-          if (msg.direction !== 'TX') return;
-          
-          const canMessage = {
-            id: parseInt(msg.id.substring(2), 16),
-            data: Buffer.from(msg.data),
-            ext: msg.id.length > 5 // Simple heuristic for extended IDs
-          };
-          
-          canChannel.send(canMessage);
-          stats.messagesSent++;
-          
-          // Create a new log message
-          const logMessage = {
-            ...msg,
-            timestamp: getTimestamp(),
-            note: 'Replayed'
-          };
-          
-          // Add to message cache
-          messageCache.push(logMessage);
-          if (messageCache.length > MAX_CACHE_SIZE) {
-            messageCache.shift();
-          }
-          
-          // Log to file if active
-          logMessageToFile(logMessage);
-          
-          // Broadcast the message
-          io.emit('can-message', logMessage);
-          io.emit('stats', stats);
-        }, index * (100 / speedFactor)); // Basic timing, adjust as needed
+        // Skip if it's not a TX message (we only replay what was sent before)
+        if (msg.direction !== 'TX') return;
+        
+        // Every cached message keeps its 100ms slot, basic timing
+        frames.push({
+          id: parseInt(msg.id.substring(2), 16),
+          data: Buffer.from(msg.data),
+          ext: msg.id.length > 5, // Simple heuristic for extended IDs
+          delay: (index - previous) * REPLAY_INTERVAL_MS
+        });
+        replayed.push(msg);
+        previous = index;
       });
+      
+      playSequence(socket, frames, { speed: speedFactor, delay: frames.length ? frames[0].delay : 0 }, (frame, index) => ({
+        ...replayed[index],
+        timestamp: getTimestamp(),
+        note: 'Replayed'
+      }));
     } catch (error) {
       console.error(`[${getTimestamp()}] Error replaying messages:`, error);
       socket.emit('error', { message: 'Failed to replay messages: ' + error.message });
@@ -294,7 +387,7 @@ io.on('connection', (socket) => {
   socket.on('get-logs', () => {
     try {
       const files = fs.readdirSync(LOG_DIRECTORY)
-        .filter(file => file.endsWith('.csv'))
+        .filter(file => isLogFile(file))
         .map(file => ({
           name: file,
           path: path.join(LOG_DIRECTORY, file),
@@ -315,8 +408,8 @@ io.on('connection', (socket) => {
     try {
       const filePath = path.join(LOG_DIRECTORY, filename);
       
-      // Security check - make sure it's a CSV file in our logs directory
-      if (!filename.endsWith('.csv') || path.dirname(filePath) !== LOG_DIRECTORY) {
+      // Security check - make sure it's a log file in our logs directory
+      if (!isLogFile(filename) || path.dirname(filePath) !== LOG_DIRECTORY) {
         throw new Error('Invalid file path');
       }
       
@@ -329,21 +422,37 @@ io.on('connection', (socket) => {
     }
   });
   
-  // Download log file route
+  // Download log file route, binary logs are converted to candump text
+  // unless ?format=asc (Vector ASC) or ?format=binary is given
   app.get('/logs/:filename', (req, res) => {
     const fileName = req.params.filename;
     const filePath = path.join(LOG_DIRECTORY, fileName);
     
     // Security check
-    if (!fileName.endsWith('.csv') || path.dirname(filePath) !== LOG_DIRECTORY) {
+    if (!isLogFile(fileName) || path.dirname(filePath) !== LOG_DIRECTORY) {
       return res.status(400).send('Invalid file path');
     }
     
-    if (fs.existsSync(filePath)) {
-      res.download(filePath);
-    } else {
-      res.status(404).send('Log file not found');
+    if (!fs.existsSync(filePath)) {
+      return res.status(404).send('Log file not found');
     }
+    
+    const format = req.query.format || 'candump';
+    if (!fileName.endsWith('.canlog') || format === 'binary') {
+      return res.download(filePath);
+    }
+    
+    if (format !== 'candump' && format !== 'asc') {
+      return res.status(400).send('Invalid format');
+    }
+    
+    const converter = spawn(CANLOG_TOOL, [format, filePath]);
+    res.attachment(path.basename(fileName, '.canlog') + (format === 'asc' ? '.asc' : '.log'));
+    converter.stdout.pipe(res);
+    converter.on('error', (error) => {
+      console.error('Error converting log file:', error);
+      res.destroy(error);
+    });
   });
   
   // Pattern management
@@ -351,6 +460,7 @@ io.on('connection', (socket) => {
     try {
       knownPatterns[pattern.name] = pattern;
       fs.writeFileSync(path.join(__dirname, 'patterns.json'), JSON.stringify(knownPatterns, null, 2));
+      compilePatterns();
       io.emit('known-patterns', Object.keys(knownPatterns));
       socket.emit('notify', { type: 'success', message: `Pattern "${pattern.name}" saved` });
     } catch (error) {
@@ -372,6 +482,7 @@ io.on('connection', (socket) => {
     if (knownPatterns[patternName]) {
       delete knownPatterns[patternName];
       fs.writeFileSync(path.join(__dirname, 'patterns.json'), JSON.stringify(knownPatterns, null, 2));
+      compilePatterns();
       io.emit('known-patterns', Object.keys(knownPatterns));
       socket.emit('notify', { type: 'success', message: `Pattern "${patternName}" deleted` });
     } else {
@@ -384,12 +495,30 @@ io.on('connection', (socket) => {
   });
 });
 
-// Listen for CAN messages
-canChannel.addListener('onMessage', (msg) => {
-  try {
-    stats.messagesReceived++;
-    messageCountInLastSecond++;
+// Listen for matched CAN messages, analysis rules first, then saved patterns
+captureChannel.addListener('onMatch', (records, matches, count) => {
+  const frames = can.decodeCaptureRecords(records, records.length / CAPTURE_RECORD_SIZE);
+  
+  for (let i = 0; i < count; i++) {
+    const frame = frames[matches[2 * i]];
+    const index = matches[2 * i + 1];
+    
+    // Frames sent by this application are already shown as TX
+    if (records[matches[2 * i] * CAPTURE_RECORD_SIZE + 13] & CAPTURE_FLAG_TX) continue;
     
+    if (index < ANALYSIS_PATTERNS.length) {
+      emitCanMessage(frame);
+    } else {
+      const name = patternNames[index - ANALYSIS_PATTERNS.length];
+      io.emit('pattern-match', { name: name, timestamp: getTimestamp() });
+      io.emit('notify', { type: 'info', message: `Pattern "${name}" detected` });
+    }
+  }
+});
+
+// Format, analyze and broadcast a received message
+function emitCanMessage(msg) {
+  try {
     // Convert the data buffer to arrays for display
     const dataBuffer = Buffer.from(msg.data);
     const hexData = [...dataBuffer].map(b => b.toString(16).toUpperCase().padStart(2, '0')).join(' ');
@@ -411,22 +540,16 @@ canChannel.addListener('onMessage', (msg) => {
     logMessage.analysis = analyzeCanMessage(msg);
     
     // Add to message cache for possible later replay
-    messageCache.push(logMessage);
-    if (messageCache.length > MAX_CACHE_SIZE) {
-      messageCache.shift();
-    }
-    
-    // Log to file if active
-    logMessageToFile(logMessage);
+    cacheMessage(logMessage);
     
-    // Broadcast the received message to all clients
+    // Broadcast the received message to all clients, the counters follow
+    // with the next stats interval
     io.emit('can-message', logMessage);
-    io.emit('stats', stats);
   } catch (error) {
     console.error(`[${getTimestamp()}] Error processing CAN message:`, error);
     stats.errorFrames++;
   }
-});
+}
 
 // Function to analyze CAN messages based on their ID
 function analyzeCanMessage(msg) {
@@ -535,8 +658,15 @@ function analyzeCanMessage(msg) {
   return analysis;
 }
 
-// Start the channel
-canChannel.start();
+// Broadcast the IDs that changed or went silent as one binary diff
+aggregator.addListener('onSnapshot', (snapshot) => {
+  io.emit('live', snapshot);
+});
+
+// Start the capture
+compilePatterns();
+captureChannel.start();
+aggregator.start(LIVE_INTERVAL_MS);
 
 // Start the server
 server.listen(PORT, () => {
@@ -550,8 +680,11 @@ process.on('SIGINT', () => {
   if (loggingActive) {
     stopLogging();
   }
-  if (canChannel) {
-    canChannel.stop();
+  if (captureChannel) {
+    captureChannel.stop();
+  }
+  if (aggregator) {
+    aggregator.stop();
   }
   server.close(() => {
     process.exit(0);
@@ -40,6 +40,7 @@ const replayCountInput = document.getElementById('replay-count');
 const replaySpeedInput = document.getElementById('replay-speed');
 const startReplayBtn = document.getElementById('start-replay');
 const maxLogRowsInput = document.getElementById('max-log-rows');
+const liveTable = document.getElementById('live-table').querySelector('tbody');
 
 // State variables
 let activeFilter = null;
@@ -218,6 +219,57 @@ socket.on('can-message', (message) => {
     addMessageToLog(message);
 });
 
+// Live table, binary diffs of the server's FrameAggregator: 24 byte header,
+// 96 byte entries (80 byte capture record, count, rate, first value), then
+// last, min and max of every decoded signal as float64
+const liveRows = new Map();
+
+socket.on('live', (snapshot) => {
+    const view = new DataView(snapshot);
+    const count = view.getUint32(8, true);
+    const valuesOffset = 24 + count * 96;
+    
+    for (let i = 0; i < count; i++) {
+        const offset = 24 + i * 96;
+        const canId = view.getUint32(offset + 8, true);
+        const ext = (canId & 0x80000000) !== 0;
+        const id = ext ? canId & 0x1FFFFFFF : canId & 0x7FF;
+        const len = view.getUint8(offset + 12);
+        const key = view.getUint8(offset + 14) + ':' + canId;
+        
+        let row = liveRows.get(key);
+        if (!row) {
+            row = document.createElement('tr');
+            row.innerHTML = '<td></td><td></td><td></td><td></td><td class="data-cell"></td><td class="data-cell"></td>';
+            row.cells[0].textContent = '0x' + id.toString(16).toUpperCase().padStart(ext ? 8 : 3, '0');
+            liveRows.set(key, row);
+            liveTable.appendChild(row);
+        }
+        
+        const data = [];
+        for (let b = 0; b < len; b++) {
+            data.push(view.getUint8(offset + 16 + b).toString(16).toUpperCase().padStart(2, '0'));
+        }
+        
+        const signals = [];
+        const first = valuesOffset + view.getUint32(offset + 92, true) * 8;
+        for (let s = 0; s < view.getUint8(offset + 15); s++) {
+            const value = view.getFloat64(first + s * 24, true);
+            const min = view.getFloat64(first + s * 24 + 8, true);
+            const max = view.getFloat64(first + s * 24 + 16, true);
+            signals.push(isNaN(value) ? '-' : `${value} [${min}..${max}]`);
+        }
+        
+        const rate = view.getFloat32(offset + 88, true);
+        row.cells[1].textContent = Number(view.getBigUint64(offset + 80, true));
+        row.cells[2].textContent = rate.toFixed(1);
+        row.cells[3].textContent = len;
+        row.cells[4].textContent = data.join(' ');
+        row.cells[5].textContent = signals.join(', ');
+        row.classList.toggle('silent', rate === 0);
+    }
+});
+
 socket.on('logging-status', (status) => {
     if (!loggingToggle) return;
     
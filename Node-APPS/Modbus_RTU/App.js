@@ -1,4 +1,5 @@
 const { SerialPort } = require('serialport');
+const { ModbusFramer } = require('@serialport/bindings-cpp');
 const crc = require('crc');
 const readline = require('readline');
 const pigpio = require('pigpio');
@@ -14,6 +15,11 @@ const RS485_CONTROL_PIN = 21;        // DE/RE pin for RS485 module
 const RS485_TX_PIN_VALUE = 1;        // HIGH for transmit
 const RS485_RX_PIN_VALUE = 0;        // LOW for receive
 
+// Let the UART driver switch the transceiver around every write (TIOCSRS485)
+// instead of toggling the GPIO above from JS. Requires DE/RE to be wired to
+// the RTS pin of the UART.
+const RS485_KERNEL_DIRECTION = false;
+
 // Modbus function codes
 const FUNC_READ_COILS = 0x01;
 const FUNC_READ_DISCRETE = 0x02;
@@ -57,9 +63,15 @@ const port = new SerialPort({
   baudRate: BAUD_RATE,
   dataBits: 8,
   stopBits: 1,
-  parity: 'none'
+  parity: 'none',
+  ...(RS485_KERNEL_DIRECTION && {
+    rs485: { enabled: true, rtsOnSend: true, rtsAfterSend: false }
+  })
 });
 
+// Modbus RTU framer reading the port natively, created once the port is open
+let framer;
+
 // Calculate Modbus CRC16
 function calculateCRC(buffer) {
   return crc.crc16modbus(buffer);
@@ -89,6 +101,10 @@ function printHexBuffer(buffer) {
 
 // Set RS485 direction
 function setRS485Direction(direction) {
+  if (RS485_KERNEL_DIRECTION) {
+    return; // The driver switches direction
+  }
+  
   try {
     directionPin.digitalWrite(direction);
   } catch (error) {
@@ -103,69 +119,46 @@ async function sendModbusCommand(cmdBuffer) {
     console.log('Sending Modbus command:');
     printHexBuffer(cmdBuffer);
     
-    // Prepare for response
-    let responseData = Buffer.alloc(0);
     let responseTimeout;
     
-    // Response handler
-    const dataHandler = (data) => {
-      responseData = Buffer.concat([responseData, data]);
-      
-      // If we have enough data to determine the expected length
-      if (responseData.length >= 3) {
-        let expectedLength;
-        
-        // Determine expected length based on function code
-        const functionCode = responseData[1];
-        
-        // Check if it's an exception response
-        if ((functionCode & 0x80) !== 0) {
-          expectedLength = 5; // Exception responses are 5 bytes
-        } else {
-          switch (functionCode) {
-            case FUNC_READ_COILS:
-            case FUNC_READ_DISCRETE:
-            case FUNC_READ_HOLDING:
-            case FUNC_READ_INPUT:
-              // These responses have a byte count field at index 2
-              if (responseData.length >= 3) {
-                expectedLength = responseData[2] + 5; // Header(3) + byte count field value + CRC(2)
-              }
-              break;
-            case FUNC_WRITE_COIL:
-            case FUNC_WRITE_HOLDING:
-              expectedLength = 8; // Fixed length for single write responses
-              break;
-            case FUNC_WRITE_MULTIPLE_COILS:
-            case FUNC_WRITE_MULTIPLE_REGS:
-              expectedLength = 8; // Fixed length for multiple write responses
-              break;
-            default:
-              // Unknown function code, wait for more data or timeout
-              break;
-          }
-        }
-        
-        // If we know the expected length and have received enough data
-        if (expectedLength && responseData.length >= expectedLength) {
-          clearTimeout(responseTimeout);
-          port.removeListener('data', dataHandler);
-          resolve(responseData);
-        }
-      }
+    // The framer in the serialport bindings reassembles the response and
+    // checks its CRC, the handler is called once per complete frame. Broken
+    // frames are logged by the framer's error handler and the timeout ends
+    // the transaction
+    const frameHandler = (frame) => {
+      clearTimeout(responseTimeout);
+      removeHandlers();
+      resolve(frame);
+    };
+    
+    const removeHandlers = () => {
+      framer.removeListener('frame', frameHandler);
     };
     
     // Set timeout for response
     responseTimeout = setTimeout(() => {
-      port.removeListener('data', dataHandler);
+      removeHandlers();
       reject(new Error('Response timeout'));
     }, 2000);
     
-    // Set up the data listener
-    port.on('data', dataHandler);
+    // Set up the frame listener
+    framer.on('frame', frameHandler);
     
-    // Clear input buffer
+    // Clear input buffer and any partially received frame
     port.flush();
+    framer.reset();
+    
+    // The driver turns the bus around within microseconds of the last bit
+    if (RS485_KERNEL_DIRECTION) {
+      port.write(cmdBuffer, (err) => {
+        if (err) {
+          clearTimeout(responseTimeout);
+          removeHandlers();
+          reject(err);
+        }
+      });
+      return;
+    }
     
     // Set to transmit mode
     setRS485Direction(RS485_TX_PIN_VALUE);
@@ -176,7 +169,7 @@ async function sendModbusCommand(cmdBuffer) {
       port.write(cmdBuffer, async (err) => {
         if (err) {
           clearTimeout(responseTimeout);
-          port.removeListener('data', dataHandler);
+          removeHandlers();
           setRS485Direction(RS485_RX_PIN_VALUE);
           reject(err);
           return;
@@ -855,6 +848,19 @@ async function handleMenuChoice(choice) {
 port.on('open', () => {
   console.log(`Serial port ${SERIAL_PORT} opened at ${BAUD_RATE} baud`);
   
+  // Frame responses natively instead of reassembling 'data' events
+  framer = new ModbusFramer(port.port, { mode: 'response' });
+  // Frames arriving outside a transaction are ignored, broken ones are
+  // logged whenever they arrive, framer.stats() counts them
+  framer.on('error', (err) => {
+    const stats = framer.stats();
+    console.error(`Modbus framer error: ${err.message} (${stats.crcErrors} CRC errors, ${stats.framingErrors} framing errors)`);
+    if (err.frame) {
+      printHexBuffer(err.frame);
+    }
+  });
+  framer.start();
+  
   // Set RS485 to receive mode initially
   setRS485Direction(RS485_RX_PIN_VALUE);
   console.log('RS485 set to receive mode');
@@ -1,6 +1,11 @@
 // CAN interface service for the CM4-IO-WIRELESS-BASE
-import { exec, spawn } from "child_process"
+// Status and configuration go through rtnetlink (socketcan's can_netlink module),
+// frames through a raw CAN socket, so no ifconfig, ip or candump process is started
+/// <reference path="../../node_modules/socketcan/src/can_netlink.d.ts" />
+import { exec } from "child_process"
 import { promisify } from "util"
+import * as can from "socketcan"
+import * as netlink from "socketcan/build/Release/can_netlink.node"
 
 const execAsync = promisify(exec)
 
@@ -19,6 +24,11 @@ export interface CANStats {
   txErrors: number
   rxDropped: number
   txDropped: number
+  state?: string
+  txErrorCounter?: number
+  rxErrorCounter?: number
+  busOff?: number
+  restarts?: number
 }
 
 export class CANInterface {
@@ -26,7 +36,9 @@ export class CANInterface {
   private interface: string
   private isInitialized = false
   private messageListeners: ((message: CANMessage) => void)[] = []
-  private canProcess: any = null
+  private rxChannel: ReturnType<typeof can.createRawChannel> | null = null
+  private txChannel: ReturnType<typeof can.createRawChannel> | null = null
+  private linkMonitor: netlink.LinkMonitor | null = null
 
   private constructor(interfaceName = "can0") {
     this.interface = interfaceName
@@ -47,25 +59,27 @@ export class CANInterface {
       }
 
       // Check if the interface exists
-      const { stdout: ifconfigOutput } = await execAsync(`ifconfig ${this.interface}`)
-      if (!ifconfigOutput.includes(this.interface)) {
+      let link: netlink.CanLink
+      try {
+        link = netlink.getLink(this.interface)
+      } catch (error) {
         console.error(`CAN interface ${this.interface} not found`)
         return false
       }
 
       // Check if the interface is already up
-      if (ifconfigOutput.includes("UP") && ifconfigOutput.includes("RUNNING")) {
+      if (link.up && link.running) {
         console.log(`CAN interface ${this.interface} is already up and running`)
+        this.startLinkMonitor()
         this.isInitialized = true
         return true
       }
 
-      // Set up the CAN interface
-      await execAsync(`sudo ip link set ${this.interface} down`)
-      await execAsync(`sudo ip link set ${this.interface} type can bitrate ${bitrate}`)
-      await execAsync(`sudo ip link set ${this.interface} up`)
+      // Set up the CAN interface, virtual interfaces have no bit timing
+      await this.configure(link.kind === "can" ? { bitrate, up: true } : { up: true })
 
       console.log(`CAN interface ${this.interface} initialized with bitrate ${bitrate}`)
+      this.startLinkMonitor()
       this.isInitialized = true
       return true
     } catch (error) {
@@ -81,12 +95,10 @@ export class CANInterface {
         return true
       }
 
-      if (this.canProcess) {
-        this.canProcess.kill()
-        this.canProcess = null
-      }
+      this.stopListening()
+      this.stopLinkMonitor()
 
-      await execAsync(`sudo ip link set ${this.interface} down`)
+      await this.configure({ up: false })
       console.log(`CAN interface ${this.interface} shut down`)
       this.isInitialized = false
       return true
@@ -96,6 +108,56 @@ export class CANInterface {
     }
   }
 
+  // Bit timing changes need the interface down first. Without CAP_NET_ADMIN
+  // the same is done through sudo ip link as before.
+  private async configure(options: netlink.LinkOptions): Promise<void> {
+    try {
+      if (options.bitrate !== undefined) {
+        netlink.setLink(this.interface, { up: false })
+      }
+      netlink.setLink(this.interface, options)
+    } catch (error: any) {
+      if (!/Operation not permitted/.test(error.message)) {
+        throw error
+      }
+
+      await execAsync(`sudo ip link set ${this.interface} down`)
+      if (options.bitrate !== undefined) {
+        await execAsync(`sudo ip link set ${this.interface} type can bitrate ${options.bitrate}`)
+      }
+      if (options.up) {
+        await execAsync(`sudo ip link set ${this.interface} up`)
+      }
+    }
+  }
+
+  // Follows link changes made elsewhere (ip link, cable unplugged, bus-off)
+  private startLinkMonitor(): void {
+    if (this.linkMonitor) return
+
+    this.linkMonitor = new netlink.LinkMonitor()
+    this.linkMonitor.addListener("onLink", (link) => {
+      if (link.name !== this.interface) return
+
+      if (link.removed) {
+        console.error(`CAN interface ${this.interface} was removed`)
+        this.isInitialized = false
+      } else if (link.state === "bus-off") {
+        console.error(`CAN interface ${this.interface} is bus-off`)
+      } else if (!link.up && this.isInitialized) {
+        console.log(`CAN interface ${this.interface} went down`)
+      }
+    })
+    this.linkMonitor.start()
+  }
+
+  private stopLinkMonitor(): void {
+    if (this.linkMonitor) {
+      this.linkMonitor.stop()
+      this.linkMonitor = null
+    }
+  }
+
   public async getStats(): Promise<CANStats | null> {
     try {
       if (!this.isInitialized) {
@@ -103,23 +165,21 @@ export class CANInterface {
         return null
       }
 
-      const { stdout } = await execAsync(`ifconfig ${this.interface}`)
-
-      // Parse the output to extract statistics
-      const rxPackets = this.extractNumber(stdout, "RX packets")
-      const txPackets = this.extractNumber(stdout, "TX packets")
-      const rxErrors = this.extractNumber(stdout, "RX errors")
-      const txErrors = this.extractNumber(stdout, "TX errors")
-      const rxDropped = this.extractNumber(stdout, "dropped", "RX")
-      const txDropped = this.extractNumber(stdout, "dropped", "TX")
+      const link = netlink.getLink(this.interface)
+      const stats = link.stats
 
       return {
-        rxPackets,
-        txPackets,
-        rxErrors,
-        txErrors,
-        rxDropped,
-        txDropped,
+        rxPackets: stats ? stats.rxPackets : 0,
+        txPackets: stats ? stats.txPackets : 0,
+        rxErrors: stats ? stats.rxErrors : 0,
+        txErrors: stats ? stats.txErrors : 0,
+        rxDropped: stats ? stats.rxDropped : 0,
+        txDropped: stats ? stats.txDropped : 0,
+        state: link.state,
+        txErrorCounter: link.berrCounter?.tx,
+        rxErrorCounter: link.berrCounter?.rx,
+        busOff: link.deviceStats?.busOff,
+        restarts: link.deviceStats?.restarts,
       }
     } catch (error) {
       console.error(`Failed to get stats for CAN interface ${this.interface}:`, error)
@@ -127,23 +187,13 @@ export class CANInterface {
     }
   }
 
-  private extractNumber(text: string, pattern: string, section?: string): number {
+  // Full rtnetlink view of the interface: bit timing, controller state, error counters
+  public getLinkStatus(): netlink.CanLink | null {
     try {
-      let regex
-      if (section) {
-        // If a section is specified, look for the pattern within that section
-        const sectionRegex = new RegExp(`${section}[^\\n]*${pattern}\\s+(\\d+)`)
-        const match = text.match(sectionRegex)
-        return match ? Number.parseInt(match[1], 10) : 0
-      } else {
-        // Otherwise, look for the pattern anywhere in the text
-        regex = new RegExp(`${pattern}\\s+(\\d+)`)
-        const match = text.match(regex)
-        return match ? Number.parseInt(match[1], 10) : 0
-      }
+      return netlink.getLink(this.interface)
     } catch (error) {
-      console.error(`Error extracting number for pattern ${pattern}:`, error)
-      return 0
+      console.error(`Failed to get status of CAN interface ${this.interface}:`, error)
+      return null
     }
   }
 
@@ -159,29 +209,11 @@ export class CANInterface {
         data = Buffer.from(data)
       }
 
-      // Format the data as a hex string
-      const dataHex =
-        data
-          .toString("hex")
-          .match(/.{1,2}/g)
-          ?.join(" ") || ""
-
-      // Build the cansend command
-      let command = `cansend ${this.interface} `
-
-      if (extended) {
-        command += `${id.toString(16).padStart(8, "0")}#`
-      } else {
-        command += `${id.toString(16).padStart(3, "0")}#`
+      if (!this.txChannel) {
+        this.txChannel = can.createRawChannel(this.interface)
       }
 
-      if (rtr) {
-        command += "R"
-      } else {
-        command += dataHex
-      }
-
-      await execAsync(command)
+      this.txChannel.send({ id, ext: extended, rtr, data })
       return true
     } catch (error) {
       console.error(`Failed to send CAN message on interface ${this.interface}:`, error)
@@ -195,68 +227,42 @@ export class CANInterface {
       return false
     }
 
-    if (this.canProcess) {
+    if (this.rxChannel) {
       console.log("Already listening for CAN messages")
       return true
     }
 
     try {
-      // Start candump process to listen for CAN messages
-      this.canProcess = spawn("candump", [this.interface])
-
-      this.canProcess.stdout.on("data", (data: Buffer) => {
-        const lines = data.toString().trim().split("\n")
-
-        for (const line of lines) {
-          try {
-            // Parse candump output format: can0 123#DEADBEEF
-            const match = line.match(/\s*(\w+)\s+([0-9A-F]+)#([0-9A-F]+)/i)
-            if (match) {
-              const [, iface, idStr, dataStr] = match
-
-              if (iface === this.interface) {
-                const id = Number.parseInt(idStr, 16)
-                const data = Buffer.from(dataStr.replace(/\s+/g, ""), "hex")
-
-                const message: CANMessage = {
-                  id,
-                  data,
-                  timestamp: Date.now(),
-                  extended: idStr.length > 3,
-                  rtr: false,
-                }
-
-                // Notify all listeners
-                this.messageListeners.forEach((listener) => listener(message))
-              }
-            }
-          } catch (error) {
-            console.error("Error parsing CAN message:", error)
-          }
+      this.rxChannel = can.createRawChannel(this.interface, true)
+
+      this.rxChannel.addListener("onMessage", (msg: any) => {
+        const message: CANMessage = {
+          id: msg.id,
+          data: msg.data,
+          timestamp: msg.ts_sec !== undefined ? msg.ts_sec * 1000 + Math.floor((msg.ts_usec || 0) / 1000) : Date.now(),
+          extended: !!msg.ext,
+          rtr: !!msg.rtr,
         }
-      })
 
-      this.canProcess.stderr.on("data", (data: Buffer) => {
-        console.error(`candump error: ${data.toString()}`)
+        // Notify all listeners
+        this.messageListeners.forEach((listener) => listener(message))
       })
 
-      this.canProcess.on("close", (code: number) => {
-        console.log(`candump process exited with code ${code}`)
-        this.canProcess = null
-      })
+      this.rxChannel.start()
 
       console.log(`Started listening for CAN messages on ${this.interface}`)
       return true
     } catch (error) {
       console.error(`Failed to start listening for CAN messages on ${this.interface}:`, error)
+      this.rxChannel = null
       return false
     }
   }
 
   public stopListening(): boolean {
-    if (this.canProcess) {
-      this.canProcess.kill()
-      this.canProcess = null
+    if (this.rxChannel) {
+      this.rxChannel.stop()
+      this.rxChannel = null
       console.log(`Stopped listening for CAN messages on ${this.interface}`)
       return true
     }
@@ -9,6 +9,8 @@ const nextConfig = {
   images: {
     unoptimized: true,
   },
+  // Native addons are loaded by node at runtime instead of being bundled
+  serverExternalPackages: ['socketcan'],
   // Allow cross-origin requests from local network
   allowedDevOrigins: [
     '192.168.18.9',  // Add the specific IP that's trying to access